@@ -39,6 +39,20 @@ ConfigWindow::ConfigWindow(ConfigStateAbstr *const parent)
 	dtEntry("dt (time step):", &parent->app->styleManager),
 	stepsPerFrameEntry("steps per frame:", &parent->app->styleManager),
 	frameCapacityEntry("frame capacity:", &parent->app->styleManager),
+	threadCountEntry("computation threads:", &parent->app->styleManager),
+	solverLabel("pressure solver:"),
+	preconditionerLabel("preconditioner:"),
+	cellIterationLabel("cell iteration:"),
+	extrapolationLabel("pressure extrapolation:"),
+	stopCriterionLabel("relaxation stopping:"),
+	pressureToleranceEntry("pressure tolerance:", &parent->app->styleManager),
+	residualCheckPeriodEntry("sweeps per residual check:", &parent->app->styleManager),
+	pressureIterationCapEntry("max. solver iter. per step:", &parent->app->styleManager),
+	precisionLabel("relaxation precision:"),
+	timeSteppingLabel("time stepping:"),
+	courantNumberEntry("max. Courant number:", &parent->app->styleManager),
+	minDtEntry("min. dt (adaptive):", &parent->app->styleManager),
+	advectionLabel("advection:"),
 	physFrame("physics configuration"),
 	compFrame("computation configuration"),
 	backHomeButton("back to home"),
@@ -69,6 +83,52 @@ ConfigWindow::ConfigWindow(ConfigStateAbstr *const parent)
 	dtEntry.attachTo(compGrid, 0, 2);
 	stepsPerFrameEntry.attachTo(compGrid, 0, 3);
 	frameCapacityEntry.attachTo(compGrid, 0, 4);
+	threadCountEntry.attachTo(compGrid, 0, 5);
+	solverLabel.set_xalign(0);
+	for (const str &name : PressureSolverNames)
+		solverSelector.append(name);
+	compGrid.attach(solverLabel, 0, 6);
+	compGrid.attach(solverSelector, 1, 6);
+	preconditionerLabel.set_xalign(0);
+	for (const str &name : PcgPreconditionerNames)
+		preconditionerSelector.append(name);
+	compGrid.attach(preconditionerLabel, 0, 7);
+	compGrid.attach(preconditionerSelector, 1, 7);
+	cellIterationLabel.set_xalign(0);
+	for (const str &name : CellIterationModeNames)
+		cellIterationSelector.append(name);
+	compGrid.attach(cellIterationLabel, 0, 8);
+	compGrid.attach(cellIterationSelector, 1, 8);
+	extrapolationLabel.set_xalign(0);
+	for (const str &name : PressureExtrapolationNames)
+		extrapolationSelector.append(name);
+	compGrid.attach(extrapolationLabel, 0, 9);
+	compGrid.attach(extrapolationSelector, 1, 9);
+	stopCriterionLabel.set_xalign(0);
+	for (const str &name : PressureStopCriterionNames)
+		stopCriterionSelector.append(name);
+	compGrid.attach(stopCriterionLabel, 0, 10);
+	compGrid.attach(stopCriterionSelector, 1, 10);
+	pressureToleranceEntry.attachTo(compGrid, 0, 11);
+	residualCheckPeriodEntry.attachTo(compGrid, 0, 12);
+	pressureIterationCapEntry.attachTo(compGrid, 0, 13);
+	precisionLabel.set_xalign(0);
+	for (const str &name : RelaxationPrecisionNames)
+		precisionSelector.append(name);
+	compGrid.attach(precisionLabel, 0, 14);
+	compGrid.attach(precisionSelector, 1, 14);
+	timeSteppingLabel.set_xalign(0);
+	for (const str &name : TimeSteppingModeNames)
+		timeSteppingSelector.append(name);
+	compGrid.attach(timeSteppingLabel, 0, 15);
+	compGrid.attach(timeSteppingSelector, 1, 15);
+	courantNumberEntry.attachTo(compGrid, 0, 16);
+	minDtEntry.attachTo(compGrid, 0, 17);
+	advectionLabel.set_xalign(0);
+	for (const str &name : AdvectionSchemeNames)
+		advectionSelector.append(name);
+	compGrid.attach(advectionLabel, 0, 18);
+	compGrid.attach(advectionSelector, 1, 18);
 	
 	compFrame.add(compGrid);
 
@@ -130,6 +190,86 @@ void ConfigWindow::connectWindowEventHandlers()
 		ConvUtils::updatePosIntIndicator(frameCapacityEntry, parent->params->frameCapacity, SimulationParamsPreset::DefaultFrameCapacity, SimulationParamsPreset::MinFrameCapacity, SimulationParamsPreset::MaxFrameCapacity);
 		parent->validityChangeListeners.invoke();
 	});
+	threadCountEntry.connectInputHandler([this]
+	{
+		ConvUtils::updatePosIntIndicator(threadCountEntry, parent->params->threadCount, SimulationParamsPreset::DefaultThreadCount, SimulationParamsPreset::MinThreadCount, SimulationParamsPreset::MaxThreadCount);
+		parent->validityChangeListeners.invoke();
+	});
+	solverSelector.signal_changed().connect([this]
+	{
+		parent->params->pressureSolver = PressureSolverType(solverSelector.get_active_row_number());
+		const bool pcg = parent->params->pressureSolver == PressureSolverType::ConjugateGradient;
+		preconditionerLabel.set_sensitive(pcg);
+		preconditionerSelector.set_sensitive(pcg);
+		updatePressureStopSensitivity();
+	});
+	stopCriterionSelector.signal_changed().connect([this]
+	{
+		parent->params->pressureStopCriterion = PressureStopCriterion(stopCriterionSelector.get_active_row_number());
+		updatePressureStopSensitivity();
+	});
+	precisionSelector.signal_changed().connect([this]
+	{
+		parent->params->relaxationPrecision = RelaxationPrecision(precisionSelector.get_active_row_number());
+		updatePressureStopSensitivity();
+	});
+	pressureToleranceEntry.connectInputHandler([this]
+	{
+		ConvUtils::updatePosRealIndicator(pressureToleranceEntry, parent->params->pressureTolerance, SimulationParamsPreset::DefaultPressureTolerance, SimulationParamsPreset::MinPressureTolerance, SimulationParamsPreset::MaxPressureTolerance);
+		parent->validityChangeListeners.invoke();
+	});
+	residualCheckPeriodEntry.connectInputHandler([this]
+	{
+		ConvUtils::updatePosIntIndicator(residualCheckPeriodEntry, parent->params->residualCheckPeriod, SimulationParamsPreset::DefaultResidualCheckPeriod, SimulationParamsPreset::MaxResidualCheckPeriod);
+		parent->validityChangeListeners.invoke();
+	});
+	pressureIterationCapEntry.connectInputHandler([this]
+	{
+		ConvUtils::updatePosIntIndicator(pressureIterationCapEntry, parent->params->pressureIterationCap, SimulationParamsPreset::DefaultPressureIterationCap, SimulationParamsPreset::MaxPressureIterationCap);
+		parent->validityChangeListeners.invoke();
+	});
+	preconditionerSelector.signal_changed().connect([this]
+	{
+		parent->params->pcgPreconditioner = PcgPreconditionerType(preconditionerSelector.get_active_row_number());
+	});
+	cellIterationSelector.signal_changed().connect([this]
+	{
+		parent->params->cellIteration = CellIterationMode(cellIterationSelector.get_active_row_number());
+	});
+	extrapolationSelector.signal_changed().connect([this]
+	{
+		parent->params->pressureExtrapolation = PressureExtrapolation(extrapolationSelector.get_active_row_number());
+	});
+	timeSteppingSelector.signal_changed().connect([this]
+	{
+		parent->params->timeStepping = TimeSteppingMode(timeSteppingSelector.get_active_row_number());
+		if (parent->params->timeStepping == TimeSteppingAdaptive)
+		{
+			courantNumberEntry.enable();
+			minDtEntry.enable();
+		}
+		else
+		{
+			courantNumberEntry.disable();
+			minDtEntry.disable();
+		}
+		parent->validityChangeListeners.invoke();
+	});
+	advectionSelector.signal_changed().connect([this]
+	{
+		parent->params->advection = AdvectionScheme(advectionSelector.get_active_row_number());
+	});
+	courantNumberEntry.connectInputHandler([this]
+	{
+		// the upwind advection clamps the bound to 1 (@see SimulatorClassic::adaptTimeStep)
+		ConvUtils::updatePosRealIndicator(courantNumberEntry, parent->params->courantNumber, SimulationParamsPreset::DefaultCourantNumber, SimulationParamsPreset::MinCourantNumber, SimulationParamsPreset::MaxCourantNumber);
+		parent->validityChangeListeners.invoke();
+	});
+	minDtEntry.connectInputHandler([this]
+	{
+		ConvUtils::updatePosRealIndicator(minDtEntry, parent->params->minDt, SimulationParamsPreset::DefaultMinDt, SimulationParamsPreset::MinDt, SimulationParamsPreset::MaxDt);
+		parent->validityChangeListeners.invoke();
+	});
 	dtEntry.connectInputHandler([this]
 	{
 		ConvUtils::updatePosRealIndicator(dtEntry, parent->params->dt, SimulationParamsPreset::DefaultDt, SimulationParamsPreset::MinDt, SimulationParamsPreset::MaxDt);
@@ -170,6 +310,11 @@ bool ConfigWindow::areInputsValid() const
 			&& dtEntry.hasValidInput()
 			&& stepsPerFrameEntry.hasValidInput()
 			&& frameCapacityEntry.hasValidInput()
+			&& threadCountEntry.hasValidInput()
+			&& (!isPressureToleranceUsed() || pressureToleranceEntry.hasValidInput())
+			&& (!isResidualCheckPeriodUsed() || residualCheckPeriodEntry.hasValidInput())
+			&& (!isPressureIterationCapUsed() || pressureIterationCapEntry.hasValidInput())
+			&& (parent->params->timeStepping != TimeSteppingAdaptive || (courantNumberEntry.hasValidInput() && minDtEntry.hasValidInput()))
 			&& x0sel.hasValidInput()
 			&& x1sel.hasValidInput()
 			&& y0sel.hasValidInput()
@@ -187,10 +332,72 @@ void ConfigWindow::setEntryFields()
 	dtEntry.setText(ConvUtils::defaultToString(params->dt));
 	stepsPerFrameEntry.setText(std::to_string(params->stepsPerFrame));
 	frameCapacityEntry.setText(std::to_string(params->frameCapacity));
+	threadCountEntry.setText(std::to_string(params->threadCount));
+	preconditionerSelector.set_active(params->pcgPreconditioner);
+	solverSelector.set_active(params->pressureSolver);
+	cellIterationSelector.set_active(params->cellIteration);
+	extrapolationSelector.set_active(params->pressureExtrapolation);
+	stopCriterionSelector.set_active(params->pressureStopCriterion);
+	precisionSelector.set_active(params->relaxationPrecision);
+	timeSteppingSelector.set_active(params->timeStepping);
+	courantNumberEntry.setText(ConvUtils::defaultToString(params->courantNumber));
+	minDtEntry.setText(ConvUtils::defaultToString(params->minDt));
+	advectionSelector.set_active(params->advection);
+	pressureToleranceEntry.setText(ConvUtils::defaultToString(params->pressureTolerance));
+	residualCheckPeriodEntry.setText(std::to_string(params->residualCheckPeriod));
+	pressureIterationCapEntry.setText(std::to_string(params->pressureIterationCap));
 	x0sel.setBc(params->bcx0);
 	x1sel.setBc(params->bcx1);
 	y0sel.setBc(params->bcy0);
 	y1sel.setBc(params->bcy1);
 }
 
+bool ConfigWindow::isRelaxationSelected() const
+{
+	// the automatic choice falls back to the relaxation when the spectral solver isn't suitable
+	return parent->params->pressureSolver == PressureSolverType::Relaxation || parent->params->pressureSolver == PressureSolverType::Automatic;
+}
+
+bool ConfigWindow::isPressureToleranceUsed() const
+{
+	return (isRelaxationSelected() && parent->params->pressureStopCriterion == PressureStopResidual)
+		|| parent->params->pressureSolver == PressureSolverType::ConjugateGradient;
+}
+
+bool ConfigWindow::isResidualCheckPeriodUsed() const
+{
+	// the mixed precision corrects the pressure once per the period
+	return isRelaxationSelected()
+		&& (parent->params->pressureStopCriterion == PressureStopResidual || parent->params->relaxationPrecision == RelaxationPrecisionMixed);
+}
+
+bool ConfigWindow::isPressureIterationCapUsed() const
+{
+	// the direct solvers have no iterations to cap (the automatic choice may be the relaxation)
+	return parent->params->pressureSolver != PressureSolverType::Cholesky && parent->params->pressureSolver != PressureSolverType::Spectral;
+}
+
+void ConfigWindow::updatePressureStopSensitivity()
+{
+	const bool relaxation = isRelaxationSelected();
+	stopCriterionLabel.set_sensitive(relaxation);
+	stopCriterionSelector.set_sensitive(relaxation);
+	precisionLabel.set_sensitive(relaxation);
+	precisionSelector.set_sensitive(relaxation);
+	if (isPressureToleranceUsed())
+		pressureToleranceEntry.enable();
+	else
+		pressureToleranceEntry.disable();
+	if (isResidualCheckPeriodUsed())
+		residualCheckPeriodEntry.enable();
+	else
+		residualCheckPeriodEntry.disable();
+	if (isPressureIterationCapUsed())
+		pressureIterationCapEntry.enable();
+	else
+		pressureIterationCapEntry.disable();
+	// the entries required to be valid have changed
+	parent->validityChangeListeners.invoke();
+}
+
 }
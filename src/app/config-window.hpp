@@ -11,6 +11,7 @@
 
 #include <gtkmm/button.h>
 #include <gtkmm/checkbutton.h>
+#include <gtkmm/comboboxtext.h>
 #include <gtkmm/entry.h>
 #include <gtkmm/frame.h>
 #include <gtkmm/grid.h>
@@ -59,6 +60,50 @@ private:
 	AnnotatedEntry stepsPerFrameEntry;
 	/// Entry for the maximum number of frames that can be stored at once
 	AnnotatedEntry frameCapacityEntry;
+	/// Entry for the number of threads computing the simulation
+	AnnotatedEntry threadCountEntry;
+	/// Label for the pressure solver selector
+	Gtk::Label solverLabel;
+	/// Combo box for selecting the method used to solve the Poisson equation for pressure
+	Gtk::ComboBoxText solverSelector;
+	/// Label for the preconditioner selector
+	Gtk::Label preconditionerLabel;
+	/// Combo box for selecting the preconditioner of the conjugate gradient pressure solver (only sensitive when that solver is selected)
+	Gtk::ComboBoxText preconditionerSelector;
+	/// Label for the cell iteration mode selector
+	Gtk::Label cellIterationLabel;
+	/// Combo box for selecting the way the stencil passes iterate over the points of the grid
+	Gtk::ComboBoxText cellIterationSelector;
+	/// Label for the pressure extrapolation selector
+	Gtk::Label extrapolationLabel;
+	/// Combo box for selecting the initial guess of the pressure field in each step
+	Gtk::ComboBoxText extrapolationSelector;
+	/// Label for the stopping criterion selector
+	Gtk::Label stopCriterionLabel;
+	/// Combo box for selecting the stopping criterion of the built-in relaxation (only sensitive when that solver is selected)
+	Gtk::ComboBoxText stopCriterionSelector;
+	/// Entry for the relative tolerance of the residual of the Poisson equation for pressure
+	AnnotatedEntry pressureToleranceEntry;
+	/// Entry for the number of sweeps of the relaxation between two checks of the residual
+	AnnotatedEntry residualCheckPeriodEntry;
+	/// Entry for the cap on the number of iterations of the iterative pressure solvers in one step
+	AnnotatedEntry pressureIterationCapEntry;
+	/// Label for the relaxation precision selector
+	Gtk::Label precisionLabel;
+	/// Combo box for selecting the floating-point precision of the sweeps of the built-in relaxation (only sensitive when that solver is selected)
+	Gtk::ComboBoxText precisionSelector;
+	/// Label for the time stepping mode selector
+	Gtk::Label timeSteppingLabel;
+	/// Combo box for selecting the way the time step is chosen
+	Gtk::ComboBoxText timeSteppingSelector;
+	/// Entry for the upper bound on the Courant number in the adaptive time stepping
+	AnnotatedEntry courantNumberEntry;
+	/// Entry for the lower bound on the time step in the adaptive time stepping
+	AnnotatedEntry minDtEntry;
+	/// Label for the advection scheme selector
+	Gtk::Label advectionLabel;
+	/// Combo box for selecting the discretization of the convective term
+	Gtk::ComboBoxText advectionSelector;
 
 	/// (TODO: implement) Checkbox to indicate whether the computation of the simulation should automatically pause after some time
 	Gtk::CheckButton autoStop;
@@ -106,6 +151,26 @@ private:
 	 * Sets the contents of the widgets in this window based on the simulation parameters stored in the parent state
 	 */
 	void setEntryFields();
+	/**
+	 * @return true iff the selected pressure solver is (or may turn out to be) the relaxation built into SimulatorClassic::iter
+	 */
+	bool isRelaxationSelected() const;
+	/**
+	 * @return true iff the pressure tolerance is used with the selected solver and stopping criterion
+	 */
+	bool isPressureToleranceUsed() const;
+	/**
+	 * @return true iff the residual check period is used with the selected solver, stopping criterion, and precision
+	 */
+	bool isResidualCheckPeriodUsed() const;
+	/**
+	 * @return true iff the selected solver is iterative, i.e. the cap on its iterations is used
+	 */
+	bool isPressureIterationCapUsed() const;
+	/**
+	 * Makes the widgets for the stopping of the solving of the Poisson equation for pressure sensitive iff they are relevant for the selected solver and stopping criterion
+	 */
+	void updatePressureStopSensitivity();
 public:
 	/**
 	 * Constructs the configuration window object
@@ -0,0 +1,97 @@
+/**
+ * connected-components.cpp
+ *
+ * Author: Viktor Fukala
+ * Created on 2026/10/17
+ */
+#include "connected-components.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace brandy0
+{
+
+/**
+ * Finds the root of the tree of a point in the union-find forest (halving the path to it).
+ * Every point points to a point with a lower or equal index, so the root is the first point of the tree in the row major order.
+ * @param parent union-find forest (the parent index of every point)
+ * @param i index of the point
+ * @return index of the root
+ */
+static uint32_t findRoot(uint32_t *const parent, uint32_t i)
+{
+	while (parent[i] != i)
+	{
+		parent[i] = parent[parent[i]];
+		i = parent[i];
+	}
+	return i;
+}
+
+/**
+ * Merges the trees of two points in the union-find forest (the root with the higher index is attached to the other one)
+ * @param parent union-find forest
+ * @param a index of the first point
+ * @param b index of the second point
+ */
+static void unite(uint32_t *const parent, const uint32_t a, const uint32_t b)
+{
+	const uint32_t ra = findRoot(parent, a);
+	const uint32_t rb = findRoot(parent, b);
+	if (ra < rb)
+		parent[rb] = ra;
+	else
+		parent[ra] = rb;
+}
+
+void ConnectedComponents::label(const BitGrid &mask, Grid<uint32_t> &labels, ThreadPool &pool)
+{
+	assert(labels.w == mask.w && labels.h == mask.h);
+	const uint32_t w = mask.w, h = mask.h;
+	if (w == 0 || h == 0)
+		return;
+	uint32_t *const parent = labels.data;
+	const uint32_t bandCount = std::max(1u, std::min(pool.getThreadCount(), h));
+	auto bandStart = [h, bandCount](const uint32_t b) { return h * b / bandCount; };
+
+	// the trees built for a band only contain its points, so the bands don't interfere
+	pool.run(bandCount, [&](const uint32_t b)
+	{
+		const uint32_t y0 = bandStart(b), y1 = bandStart(b + 1);
+		for (uint32_t y = y0; y < y1; y++)
+		{
+			for (uint32_t x = 0; x < w; x++)
+			{
+				const uint32_t i = x + y * w;
+				if (!mask(x, y))
+				{
+					parent[i] = NoComponent;
+					continue;
+				}
+				parent[i] = i;
+				if (x != 0 && mask(x - 1, y))
+					unite(parent, i, i - 1);
+				if (y != y0 && mask(x, y - 1))
+					unite(parent, i, i - w);
+			}
+		}
+	});
+	for (uint32_t b = 1; b < bandCount; b++)
+	{
+		const uint32_t y = bandStart(b);
+		for (uint32_t x = 0; x < w; x++)
+		{
+			if (mask(x, y) && mask(x, y - 1))
+				unite(parent, x + y * w, x + (y - 1) * w);
+		}
+	}
+	// the parent of every point precedes it, so its label is already resolved when the point is reached
+	for (uint32_t i = 0; i < w * h; i++)
+	{
+		if (parent[i] != NoComponent)
+			parent[i] = parent[parent[i]];
+	}
+}
+
+}
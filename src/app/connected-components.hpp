@@ -0,0 +1,45 @@
+/**
+ * connected-components.hpp
+ *
+ * Author: Viktor Fukala
+ * Created on 2026/10/17
+ */
+#ifndef CONNECTED_COMPONENTS_HPP
+#define CONNECTED_COMPONENTS_HPP
+
+#include <cstdint>
+
+#include "bit-grid.hpp"
+#include "grid.hpp"
+#include "thread-pool.hpp"
+
+namespace brandy0
+{
+
+/**
+ * Class with static methods for labelling the connected components of grid points
+ */
+class ConnectedComponents
+{
+public:
+	/// Label of the points that don't belong to any component
+	static constexpr uint32_t NoComponent = UINT32_MAX;
+
+	/**
+	 * Labels the components of the marked points connected through their (direct -- at most 4) neighbors.
+	 * The label of a point is the index (x + y * w) of the first point of its component in the row major order,
+	 * so a point is the first one of its component iff it is labelled by its own index.
+	 *
+	 * The labelling is done by union-find without recursion (so that its memory use doesn't depend on the sizes of the components):
+	 * the row bands of the grid are labelled in parallel, then the components are merged at the seams between the bands
+	 * and the labels are resolved in a single pass in the row major order.
+	 * @param mask grid in which the points to label are true
+	 * @param labels grid of the same dimensions as mask to store the labels in (NoComponent for the points that are false in mask)
+	 * @param pool thread pool to label the bands on
+	 */
+	static void label(const BitGrid &mask, Grid<uint32_t> &labels, ThreadPool &pool);
+};
+
+}
+
+#endif // CONNECTED_COMPONENTS_HPP
@@ -6,6 +6,7 @@
  */
 #include "conv-utils.hpp"
 
+#include <array>
 #include <iomanip>
 
 namespace brandy0
@@ -240,6 +241,21 @@ str ConvUtils::speedupToString(const double d)
 	return toFixed(d, 5);
 }
 
+str ConvUtils::bytesToString(const uint64_t bytes)
+{
+	if (bytes < 1024)
+		return std::to_string(bytes) + " B";
+	const std::array<str, 3> units{ "KiB", "MiB", "GiB" };
+	double val = bytes / 1024.;
+	uint32_t unit = 0;
+	while (val >= 1024 && unit + 1 < units.size())
+	{
+		val /= 1024;
+		unit++;
+	}
+	return toFixed(val, 1) + " " + units[unit];
+}
+
 str ConvUtils::intToZeropadString(const uint32_t i, const uint32_t width)
 {
 	std::ostringstream oss;
@@ -139,6 +139,12 @@ public:
 	 * @return converted string
 	 */
 	static str speedupToString(double d);
+	/**
+	 * Converts an amount of memory to a string with a binary unit prefix (B, KiB, MiB, GiB)
+	 * @param bytes number of bytes to convert
+	 * @return converted string
+	 */
+	static str bytesToString(uint64_t bytes);
 	/**
 	 * Converts an integer to string of a given length such that the integer's digits are preceded by zeros ('0')
 	 * if the number of the integer's own digits is smaller than the width of the string.
@@ -20,7 +20,7 @@ DisplayArea::DisplayArea(SimulationStateAbstr *const parent) : parent(parent)
 
 	parent->initListeners.plug([this, parent]
 	{
-		drawer = make_unique<FrameDrawer>(*parent->params);
+		drawer = make_unique<FrameDrawer>(*parent->params, parent->geometry);
 	});
 }
 
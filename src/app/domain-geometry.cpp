@@ -0,0 +1,128 @@
+/**
+ * domain-geometry.cpp
+ *
+ * Author: Viktor Fukala
+ * Created on 2026/10/17
+ */
+#include "domain-geometry.hpp"
+
+#include <algorithm>
+
+#include "connected-components.hpp"
+
+namespace brandy0
+{
+
+DomainGeometry::DomainGeometry(const SimulationParams &params, ThreadPool &pool)
+	: wp(params.wp), hp(params.hp), solid(wp, hp), indep(wp, hp), dirichlet(wp, hp), component(wp, hp)
+{
+	params.shapeStack.set(solid);
+	computeIndep();
+	markDirichletSides(params);
+	ConnectedComponents::label(indep, component, pool);
+	pinFloatingComponents();
+	buildBoundaryLists();
+	buildRunLists();
+}
+
+sptr<const DomainGeometry> DomainGeometry::create(const SimulationParams &params)
+{
+	ThreadPool pool(std::max(params.threadCount, 1u));
+	return make_shared<const DomainGeometry>(params, pool);
+}
+
+void DomainGeometry::computeIndep()
+{
+	for (uint32_t x = 0; x < wp; x++)
+	{
+		indep(x, 0) = indep(x, hp - 1) = false;
+	}
+	for (uint32_t y = 0; y < hp; y++)
+	{
+		indep(0, y) = indep(wp - 1, y) = false;
+	}
+	for (uint32_t y = 1; y < hp - 1; y++)
+	{
+		for (uint32_t x = 1; x < wp - 1; x++)
+		{
+			indep(x, y) = !(solid(x, y) || solid(x + 1, y)
+				|| solid(x - 1, y) || solid(x, y + 1) || solid(x, y - 1));
+		}
+	}
+}
+
+void DomainGeometry::markDirichletSides(const SimulationParams &params)
+{
+	dirichlet.set_all(false);
+	if (params.bcx0.ptype == BoundaryCondType::Dirichlet)
+		for (uint32_t y = 0; y < hp; y++)
+			dirichlet(0, y) = true;
+	if (params.bcx1.ptype == BoundaryCondType::Dirichlet)
+		for (uint32_t y = 0; y < hp; y++)
+			dirichlet(wp - 1, y) = true;
+	if (params.bcy0.ptype == BoundaryCondType::Dirichlet)
+		for (uint32_t x = 0; x < wp; x++)
+			dirichlet(x, 0) = true;
+	if (params.bcy1.ptype == BoundaryCondType::Dirichlet)
+		for (uint32_t x = 0; x < wp; x++)
+			dirichlet(x, hp - 1) = true;
+}
+
+void DomainGeometry::pinFloatingComponents()
+{
+	// the components are identified by the indices of their first points
+	vec<bool> anchored(uint64_t(wp) * hp, false);
+	for (uint32_t y = 0; y < hp; y++)
+	{
+		for (uint32_t x = 0; x < wp; x++)
+		{
+			if (!dirichlet(x, y))
+				continue;
+			if (x != 0 && indep(x - 1, y))
+				anchored[component(x - 1, y)] = true;
+			if (x + 1 != wp && indep(x + 1, y))
+				anchored[component(x + 1, y)] = true;
+			if (y != 0 && indep(x, y - 1))
+				anchored[component(x, y - 1)] = true;
+			if (y + 1 != hp && indep(x, y + 1))
+				anchored[component(x, y + 1)] = true;
+		}
+	}
+	for (uint32_t y = 0; y < hp; y++)
+	{
+		for (uint32_t x = 0; x < wp; x++)
+		{
+			const uint32_t i = x + y * wp;
+			if (component(x, y) == i && !anchored[i])
+				dirichlet(x, y) = true;
+		}
+	}
+}
+
+void DomainGeometry::buildBoundaryLists()
+{
+	for (uint32_t y = 1; y < hp - 1; y++)
+	{
+		for (uint32_t x = 1; x < wp - 1; x++)
+		{
+			if (dirichlet(x, y))
+				pinnedPoints.push_back(Point(x, y));
+			// the pinned inner points are all independent (only independent points are pinned arbitrarily), so the lists are disjoint
+			else if (!solid(x, y) && !indep(x, y))
+				obstacleBoundary.push_back({Point(x, y), uint8_t(indep(x - 1, y) | indep(x + 1, y) << 1 | indep(x, y - 1) << 2 | indep(x, y + 1) << 3)});
+		}
+	}
+}
+
+void DomainGeometry::buildRunLists()
+{
+	indepRowRuns.reserve(hp + 1);
+	for (uint32_t y = 0; y < hp; y++)
+	{
+		indepRowRuns.push_back(indepRuns.size());
+		indep.forEachRun(y, [this](const GridRun &run) { indepRuns.push_back(run); });
+	}
+	indepRowRuns.push_back(indepRuns.size());
+}
+
+}
@@ -0,0 +1,108 @@
+/**
+ * domain-geometry.hpp
+ *
+ * Author: Viktor Fukala
+ * Created on 2026/10/17
+ */
+#ifndef DOMAIN_GEOMETRY_HPP
+#define DOMAIN_GEOMETRY_HPP
+
+#include <cstdint>
+
+#include "bit-grid.hpp"
+#include "grid.hpp"
+#include "point.hpp"
+#include "ptr.hpp"
+#include "simulation-params.hpp"
+#include "thread-pool.hpp"
+#include "vec.hpp"
+
+namespace brandy0
+{
+
+/**
+ * Point at the boundary of an obstacle (an inner point of the grid that is neither solid nor independent),
+ * at which the velocity is set by the no-slip condition and the pressure is averaged from the independent neighbors
+ */
+struct ObstacleBoundaryPoint
+{
+	/// Position of the point in the grid
+	Point pos;
+	/// Mask of the independent neighbors of the point (bits 1, 2, 4, 8 for the neighbors at x - 1, x + 1, y - 1, y + 1, respectively)
+	uint8_t indepNeighbors;
+};
+
+/**
+ * Masks and lists of grid points derived from the obstacles and the boundary conditions of a simulation.
+ *
+ * The geometry is computed once per simulation and not modified afterwards,
+ * so a single instance is shared (as sptr<const DomainGeometry>) by the simulator and all the frame drawers of the simulation.
+ */
+class DomainGeometry
+{
+public:
+	/// Number of grid points along the x axis
+	uint32_t wp;
+	/// Number of grid points along the y axis
+	uint32_t hp;
+	/// Grid in which a point is true iff occupied by an obstacle
+	BitGrid solid;
+	/// Grid in which a point is true iff not solid and not at the boundary (i.e. it and all its 4 direct neighbors are non-solid)
+	BitGrid indep;
+	/**
+	 * Grid in which a point is true iff the value of pressure there is set directly by a Dirichlet boundary condition
+	 * (or arbitrarily because it didn't connect to any point with set pressure and the pressure field is determined up to a constant)
+	 */
+	BitGrid dirichlet;
+	/// Labels of the connected components of the independent points (@see ConnectedComponents::label)
+	Grid<uint32_t> component;
+	/// Inner points with pressure set by a Dirichlet boundary condition (or arbitrarily), which are pinned to zero pressure
+	vec<Point> pinnedPoints;
+	/// Points at the boundaries of obstacles, listed so that the enforcement of the boundary conditions doesn't have to scan the grid
+	vec<ObstacleBoundaryPoint> obstacleBoundary;
+	/// Maximal runs of independent points of the inner rows (in the row major order)
+	vec<GridRun> indepRuns;
+	/// Index of the first run of each row in indepRuns (with an extra entry past the last row, so that the runs of row y are indepRowRuns[y] .. indepRowRuns[y + 1] - 1)
+	vec<uint32_t> indepRowRuns;
+
+	/**
+	 * Constructs a DomainGeometry object
+	 * @param params simulation parameters to compute the geometry for
+	 * @param pool thread pool to label the connected components on
+	 */
+	DomainGeometry(const SimulationParams &params, ThreadPool &pool);
+	/**
+	 * Computes the geometry of a simulation (labelling the connected components on a pool of params.threadCount threads)
+	 * @param params simulation parameters to compute the geometry for
+	 * @return pointer to the shared geometry
+	 */
+	static sptr<const DomainGeometry> create(const SimulationParams &params);
+
+private:
+	/**
+	 * Computes indep from solid
+	 */
+	void computeIndep();
+	/**
+	 * Marks the points at the sides with a Dirichlet b.c. for pressure in dirichlet
+	 * @param params simulation parameters with the boundary conditions
+	 */
+	void markDirichletSides(const SimulationParams &params);
+	/**
+	 * Pins (marks as dirichlet) the first point of every connected component of independent points
+	 * that has no neighbor with pressure set by a Dirichlet b.c. (its pressure is only determined up to a constant)
+	 */
+	void pinFloatingComponents();
+	/**
+	 * Fills pinnedPoints and obstacleBoundary from solid, indep, and dirichlet
+	 */
+	void buildBoundaryLists();
+	/**
+	 * Fills indepRuns and indepRowRuns from indep
+	 */
+	void buildRunLists();
+};
+
+}
+
+#endif // DOMAIN_GEOMETRY_HPP
@@ -283,7 +283,7 @@ void ExportWindow::updateDurationLabel()
 	if (parent->videoExportRangeValid)
 	{
 		const double simtime = parent->videoExportEndTime - parent->videoExportStartTime;
-		const double realtime = simtime / (parent->params->dt * parent->params->stepsPerFrame * parent->videoExportPlaybackSpeedup) * parent->MsPerBaseFrame / 1000;
+		const double realtime = simtime / (parent->params->getFrameTime() * parent->videoExportPlaybackSpeedup) * parent->MsPerBaseFrame / 1000;
 		durationLabel.set_text("duration = " + ConvUtils::timeToString(simtime) + " (" + ConvUtils::timeToString(realtime) + " s)");
 		durationLabel.pseudoShow();
 	}
@@ -7,6 +7,7 @@
 #include "graphics.hpp"
 
 #include <functional>
+#include <utility>
 
 #include <giomm/resource.h>
 
@@ -176,10 +177,9 @@ void GraphicsManager::destruct()
 	ctx.reset();
 }
 
-FrameDrawer::FrameDrawer(const SimulationParams& p)
-	: w(p.w), h(p.h), wp(p.wp), hp(p.hp), dx(p.get_dx()), dy(p.get_dy()), solid(Grid<bool>(wp, hp))
+FrameDrawer::FrameDrawer(const SimulationParams& p, sptr<const DomainGeometry> geometry)
+	: w(p.w), h(p.h), wp(p.wp), hp(p.hp), dx(p.get_dx()), dy(p.get_dy()), geometry(std::move(geometry)), solid(this->geometry->solid)
 {
-	p.shapeStack.set(solid);
 }
 
 void FrameDrawer::setFrontDisplayMode(const uint32_t fdm)
@@ -311,7 +311,7 @@ void FrameDrawer::drawAll(const SimFrame& frame, GraphicsManager *const manager)
 	// draw back graphics
 	if (backDisplayMode != BackDisplayNone)
 	{
-		std::function<double(uint32_t, uint32_t)> scfield = [this, frame](const uint32_t x, const uint32_t y){
+		std::function<double(uint32_t, uint32_t)> scfield = [this, &frame](const uint32_t x, const uint32_t y){
 			if (backDisplayMode == BackDisplayVelocityMagnitude)
 			{
 				return frame.u(x, y).len();
@@ -443,7 +443,7 @@ void FrameDrawer::drawAll(const SimFrame& frame, GraphicsManager *const manager)
 
 		constexpr double line_d = .0147;
 
-		const double max_ulen = sqrt(max<vec2d, double>(frame.u, [](const vec2d u){return u.len2();}));
+		const double max_ulen = sqrt(max<double>(frame.u, [](const vec2d u){return u.len2();}));
 
 		if (frontDisplayMode == FrontDisplayVelocityArrows)
 		{
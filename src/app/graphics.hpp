@@ -14,6 +14,8 @@
 #include <giomm/resource.h>
 #include <epoxy/gl.h>
 
+#include "domain-geometry.hpp"
+#include "ptr.hpp"
 #include "sim-frame.hpp"
 #include "simulation-params.hpp"
 
@@ -118,8 +120,10 @@ private:
 	/// Height (in pixels) of the target area that should be drawn into
 	double viewh;
 
-	/// Grid indicating whether a grid point is solid
-	Grid<bool> solid;
+	/// Geometry of the simulated domain (shared with the simulator)
+	sptr<const DomainGeometry> geometry;
+	/// Grid indicating whether a grid point is solid (@see DomainGeometry::solid)
+	const BitGrid &solid;
 
 	/// The selected foreground visual mode to draw
 	uint32_t frontDisplayMode;
@@ -197,8 +201,9 @@ public:
 	/**
 	 * Constructs a FrameDrawer object
 	 * @param p parameters of the simulation, computed frames of which will later be drawn
+	 * @param geometry geometry of the simulated domain computed from p
 	 */
-	FrameDrawer(const SimulationParams &p);
+	FrameDrawer(const SimulationParams &p, sptr<const DomainGeometry> geometry);
 
 	/**
 	 * Sets the foreground visual mode for future frame draws
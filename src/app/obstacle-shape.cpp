@@ -6,7 +6,9 @@
  */
 #include "obstacle-shape.hpp"
 
+#include <algorithm>
 #include <cmath>
+#include <utility>
 
 namespace brandy0
 {
@@ -81,16 +83,75 @@ bool ObstacleShapeStack::empty() const
 	return shapes.empty();
 }
 
-void ObstacleShapeStack::fill(Grid<bool>& grid) const
+void ObstacleShapeStack::fill(BitGrid& grid) const
 {
 	for (const sptr<ObstacleShape>& shape : *this)
 		shape->fill(grid);
 }
 
-void ObstacleShapeStack::set(Grid<bool>& grid) const
+void ObstacleShapeStack::set(BitGrid& grid) const
 {
-	grid.set_all(false);
-	fill(grid);
+	maskCache->set(begin(), end(), grid);
+}
+
+ObstacleMaskCache::Entry::Entry(const uint32_t w, const uint32_t h)
+	: mask(w, h), level(0)
+{
+	mask.set_all(false);
+}
+
+ObstacleMaskCache::Entry &ObstacleMaskCache::getEntry(const uint32_t w, const uint32_t h)
+{
+	auto it = std::find_if(entries.begin(), entries.end(), [w, h](const uptr<Entry> &e) { return e->mask.w == w && e->mask.h == h; });
+	if (it == entries.end())
+	{
+		if (entries.size() == MaxEntries)
+			entries.pop_back();
+		entries.insert(entries.begin(), make_unique<Entry>(w, h));
+	}
+	else
+		std::rotate(entries.begin(), it, it + 1);
+	return *entries.front();
+}
+
+void ObstacleMaskCache::set(const ObstacleShapeStackConstIterator begin, const ObstacleShapeStackConstIterator end, BitGrid &grid)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	Entry &e = getEntry(grid.w, grid.h);
+	const uint32_t count = end - begin;
+	uint32_t common = 0;
+	while (common < count && common < e.shapes.size() && e.shapes[common] == begin[common])
+		common++;
+	// undo the shapes that differ from the requested ones or are hidden
+	for (; e.level > common; e.level--)
+	{
+		for (const GridRun &run : e.added[e.level - 1])
+			e.mask.set_span(run.y, run.x0, run.x1, false);
+	}
+	// the recorded shapes beyond the common prefix can only be redone if the requested shapes end within the prefix
+	if (common < count)
+	{
+		e.shapes.resize(common);
+		e.added.resize(common);
+	}
+	for (; e.level < count; e.level++)
+	{
+		if (e.level == e.shapes.size())
+		{
+			// rasterize the new shape into a copy of the mask and record the points it has made solid
+			BitGrid next = e.mask;
+			begin[e.level]->fill(next);
+			next.subtract(e.mask);
+			vec<GridRun> runs;
+			for (uint32_t y = 0; y < grid.h; y++)
+				next.forEachRun(y, [&runs](const GridRun &run) { runs.push_back(run); });
+			e.shapes.push_back(begin[e.level]);
+			e.added.push_back(std::move(runs));
+		}
+		for (const GridRun &run : e.added[e.level])
+			e.mask.set_span(run.y, run.x0, run.x1, true);
+	}
+	grid = e.mask;
 }
 
 ObstacleEllipse::ObstacleEllipse(const bool negative, const vec2d& p0, const vec2d& p1)
@@ -105,17 +166,48 @@ ObstacleEllipse::ObstacleEllipse(const bool negative, const vec2d& center, const
 {
 }
 
-void ObstacleEllipse::fill(Grid<bool>& grid) const
+bool ObstacleEllipse::inside(const vec2d p) const
+{
+	const vec2d rel = p - center;
+	return (rel.x / xhaxis) * (rel.x / xhaxis) + (rel.y / yhaxis) * (rel.y / yhaxis) < 1;
+}
+
+void ObstacleEllipse::fill(BitGrid& grid) const
 {
-	for (uint32_t y = 0; y < grid.h; y++)
+	if (grid.w < 2 || grid.h < 2)
 	{
-		for (uint32_t x = 0; x < grid.w; x++)
-		{
-			const vec2d crs(x / double(grid.w - 1), y / double(grid.h - 1));
-			const vec2d rel = crs - center;
-			const bool inside = (rel.x / xhaxis) * (rel.x / xhaxis) + (rel.y / yhaxis) * (rel.y / yhaxis) < 1;
-			grid(x, y) = grid(x, y) || inside;
-		}
+		for (uint32_t y = 0; y < grid.h; y++)
+			for (uint32_t x = 0; x < grid.w; x++)
+				grid(x, y) = grid(x, y) || inside(vec2d(x / double(grid.w - 1), y / double(grid.h - 1)));
+		return;
+	}
+	const int64_t maxX = grid.w - 1, maxY = grid.h - 1;
+	auto clampX = [maxX](const double x) { return std::isnan(x) ? 0 : int64_t(std::max(-1., std::min(double(maxX + 1), x))); };
+	auto clampY = [maxY](const double y) { return std::isnan(y) ? 0 : int64_t(std::max(-1., std::min(double(maxY + 1), y))); };
+	// only the rows crossing the bounding box (with a margin of one row for the rounding errors) can contain inner points
+	const int64_t y0 = std::max<int64_t>(0, clampY(std::floor((center.y - yhaxis) * maxY)) - 1);
+	const int64_t y1 = std::min<int64_t>(maxY, clampY(std::ceil((center.y + yhaxis) * maxY)) + 1);
+	for (int64_t y = y0; y <= y1; y++)
+	{
+		const double py = y / double(maxY);
+		auto in = [this, py, maxX](const int64_t x) { return inside(vec2d(x / double(maxX), py)); };
+		// the inner points of a row form a contiguous span (the tested expression is monotonic on both sides of the center),
+		// so its approximate ends are widened by one point and then adjusted with the exact test
+		const double relY = (py - center.y) / yhaxis;
+		const double halfWidth = xhaxis * std::sqrt(std::max(0., 1 - relY * relY));
+		int64_t x0 = std::max<int64_t>(0, clampX(std::floor((center.x - halfWidth) * maxX)) - 1);
+		int64_t x1 = std::min<int64_t>(maxX, clampX(std::ceil((center.x + halfWidth) * maxX)) + 1);
+		while (x0 <= x1 && !in(x0))
+			x0++;
+		while (x1 >= x0 && !in(x1))
+			x1--;
+		if (x0 > x1)
+			continue;
+		while (x0 > 0 && in(x0 - 1))
+			x0--;
+		while (x1 < maxX && in(x1 + 1))
+			x1++;
+		grid.set_span(y, x0, x1 + 1, true);
 	}
 }
 
@@ -201,14 +293,108 @@ void ObstaclePolygon::draw(const Cairo::RefPtr<Cairo::Context>& cr) const
 	cr->fill();
 }
 
-void ObstaclePolygon::fill(Grid<bool>& grid) const
+void ObstaclePolygon::fill(BitGrid& grid) const
 {
-	for (uint32_t y = 0; y < grid.h; y++)
+	if (grid.w < 2 || grid.h < 2)
+	{
+		for (uint32_t y = 0; y < grid.h; y++)
+			for (uint32_t x = 0; x < grid.w; x++)
+				grid(x, y) = grid(x, y) || inside(vec2d(x / double(grid.w - 1), y / double(grid.h - 1)));
+		return;
+	}
+	const int64_t maxX = grid.w - 1, maxY = grid.h - 1;
+	double minPx = ps[0].x, maxPx = ps[0].x, minPy = ps[0].y, maxPy = ps[0].y;
+	for (const vec2d v : ps)
+	{
+		minPx = std::min(minPx, v.x);
+		maxPx = std::max(maxPx, v.x);
+		minPy = std::min(minPy, v.y);
+		maxPy = std::max(maxPy, v.y);
+	}
+	const double extent = std::max(maxPx - minPx, maxPy - minPy);
+	// inside() counts the sides crossing the vertical line through the point, so the polygon is rasterized by columns
+	// (only those crossing the bounding box, with a margin of one column for the rounding errors)
+	const int64_t x0 = std::max<int64_t>(0, int64_t(std::max(-1., std::floor(minPx * maxX))) - 1);
+	const int64_t x1 = std::min<int64_t>(maxX, int64_t(std::min(double(maxX + 1), std::ceil(maxPx * maxX))) + 1);
+	const int64_t y0 = std::max<int64_t>(0, int64_t(std::max(-1., std::floor(minPy * maxY))) - 1);
+	const int64_t y1 = std::min<int64_t>(maxY, int64_t(std::min(double(maxY + 1), std::ceil(maxPy * maxY))) + 1);
+	/// Side crossing a column: the rows from threshold on are on one side of it and the rows before threshold on the other one
+	struct Crossing
+	{
+		/// Index of the first row at which the contribution of the side to the winding count is +1 (for rising) or -1 (otherwise)
+		int64_t threshold;
+		/// True iff the contribution of the side is -1 before threshold and +1 from threshold on
+		bool rising;
+		/// Number of rows around threshold in which the point may lie on the side (which is tested exactly)
+		int64_t margin;
+	};
+	vec<Crossing> crossings;
+	for (int64_t x = x0; x <= x1; x++)
 	{
-		for (uint32_t x = 0; x < grid.w; x++)
+		const double px = x / double(maxX);
+		// the sides crossing the column are determined by the vertices' x coordinates alone unless a vertex lies on the column,
+		// and a side not crossing the column can only contain its points (up to the rounding errors of onSegment) if its end is at the column,
+		// so the columns (nearly) passing through a vertex are tested exactly
+		bool vertexAtColumn = false;
+		for (const vec2d v : ps)
+			vertexAtColumn = vertexAtColumn || std::abs(v.x - px) <= 1e-7 * extent;
+		if (vertexAtColumn)
+		{
+			for (int64_t y = y0; y <= y1; y++)
+				grid(x, y) = grid(x, y) || inside(vec2d(px, y / double(maxY)));
+			continue;
+		}
+
+		crossings.clear();
+		auto addSide = [&crossings, px, maxY](const vec2d v0, const vec2d v1)
+		{
+			if ((v0.x < px) == (v1.x < px))
+				return;
+			// the sign of the cross product is monotonic along the column, so the row at which it changes is found by binary search
+			// (evaluating the same expression as inside(), so that the results match exactly)
+			const vec2d v = v1 - v0;
+			auto left = [v, v0, px, maxY](const int64_t y) { return v.cross(vec2d(px, y / double(maxY)) - v0) > 0; };
+			const bool rising = v.x > 0;
+			int64_t lo = 0, hi = maxY + 1;
+			while (lo < hi)
+			{
+				const int64_t mid = (lo + hi) / 2;
+				if (left(mid) == rising)
+					hi = mid;
+				else
+					lo = mid + 1;
+			}
+			// a point counts as lying on the side if it is collinear with it up to the rounding errors of onSegment,
+			// which covers more rows around the threshold for sides nearly parallel to the column
+			const int64_t margin = 2 + int64_t(std::min(double(maxY), 1e-7 * v.len2() / std::abs(v.x) * maxY));
+			crossings.push_back({lo, rising, margin});
+		};
+		addSide(ps.back(), ps.front());
+		for (uint32_t i = 0; i < ps.size() - 1; i++)
+			addSide(ps[i], ps[i + 1]);
+		if (crossings.empty())
+			continue;
+
+		// sweep the column upwards, filling the spans between consecutive thresholds with a non-zero winding count
+		std::sort(crossings.begin(), crossings.end(), [](const Crossing &a, const Crossing &b) { return a.threshold < b.threshold; });
+		int32_t steps = 0;
+		for (const Crossing &c : crossings)
+			steps += c.rising ? -1 : 1;
+		for (uint32_t i = 0; i <= crossings.size(); i++)
+		{
+			const int64_t begin = i == 0 ? 0 : crossings[i - 1].threshold;
+			const int64_t end = i == crossings.size() ? maxY + 1 : crossings[i].threshold;
+			if (steps != 0)
+				for (int64_t y = begin; y < end; y++)
+					grid(x, y) = true;
+			if (i != crossings.size())
+				steps += crossings[i].rising ? 2 : -2;
+		}
+		// the points near the sides may lie on them (which makes them inside even if the winding count is zero)
+		for (const Crossing &c : crossings)
 		{
-			const vec2d crs(x / double(grid.w - 1), y / double(grid.h - 1));
-			grid(x, y) = grid(x, y) || inside(crs);
+			for (int64_t y = std::max<int64_t>(0, c.threshold - c.margin); y <= std::min(maxY, c.threshold + c.margin); y++)
+				grid(x, y) = grid(x, y) || inside(vec2d(px, y / double(maxY)));
 		}
 	}
 }
@@ -12,7 +12,9 @@
 #include <cairomm/context.h>
 
 #include <array>
+#include <mutex>
 
+#include "bit-grid.hpp"
 #include "grid.hpp"
 #include "ptr.hpp"
 #include "str.hpp"
@@ -81,13 +83,71 @@ public:
 	 * For the purposes of the coordinate transform, assumes the grid is the (0, 0) -- (1, 1) square.
 	 * @param grid grid to modify
 	 */
-	virtual void fill(Grid<bool> &grid) const = 0;
+	virtual void fill(BitGrid &grid) const = 0;
 
 };
 
 typedef vec<sptr<ObstacleShape>>::iterator ObstacleShapeStackIterator;
 typedef vec<sptr<ObstacleShape>>::const_iterator ObstacleShapeStackConstIterator;
 
+/**
+ * Cache of the rasterized solid masks of a sequence of obstacle shapes (at a few most recently used resolutions).
+ *
+ * For each resolution, it holds the mask of a prefix of the sequence of shapes and the runs of points newly made solid by each
+ * of the shapes it has rasterized, so that the mask can be moved along the sequence in both directions by setting or clearing the runs:
+ * a pushed shape is rasterized once, and undoing and redoing its addition restores the cached state.
+ * The cache is shared by the copies of a shape stack (the shapes are identified by their addresses) and is thread-safe.
+ */
+class ObstacleMaskCache
+{
+private:
+	/**
+	 * Cached data for one resolution
+	 */
+	struct Entry
+	{
+		/// Mask of the first level shapes
+		BitGrid mask;
+		/// Shapes whose runs have been recorded (the first level of them are applied to the mask)
+		vec<sptr<ObstacleShape>> shapes;
+		/// Runs of points newly made solid by each of the shapes (compared to the mask of the preceding ones)
+		vec<vec<GridRun>> added;
+		/// Number of shapes applied to the mask
+		uint32_t level;
+
+		/**
+		 * Constructs an entry with an empty mask
+		 * @param w width of the grid
+		 * @param h height of the grid
+		 */
+		Entry(uint32_t w, uint32_t h);
+	};
+
+	/// Maximum number of resolutions cached at once
+	static constexpr uint32_t MaxEntries = 4;
+	/// Cached resolutions, the most recently used first
+	vec<uptr<Entry>> entries;
+	/// Mutex guarding the entries
+	std::mutex mutex;
+
+	/**
+	 * Finds the entry for a resolution (creating it if needed, possibly evicting the least recently used one) and moves it to the front
+	 * @param w width of the grid
+	 * @param h height of the grid
+	 * @return the entry
+	 */
+	Entry &getEntry(uint32_t w, uint32_t h);
+
+public:
+	/**
+	 * Sets a grid to the mask of a sequence of shapes
+	 * @param begin begin iterator of the shapes
+	 * @param end end iterator of the shapes
+	 * @param grid grid to be set (its dimensions determine the resolution)
+	 */
+	void set(ObstacleShapeStackConstIterator begin, ObstacleShapeStackConstIterator end, BitGrid &grid);
+};
+
 /**
  * A stack of obstacle shapes with an index of the topmost shown shape.
  * Aallows for undo -- decrement index, redo -- increment index, add shape -- pop down to index & push new shape
@@ -97,6 +157,8 @@ class ObstacleShapeStack
 private:
 	/// The number of shown shapes (the first shownPointer shapes from the bottom of the stack are shown)
 	uint32_t shownPointer = 0;
+	/// Cache of the rasterized masks (shared with the copies of this stack)
+	sptr<ObstacleMaskCache> maskCache = make_shared<ObstacleMaskCache>();
 
 public:
 	/// Stack of all the shapes (possibly even some which are not shown (@see shownPointer))
@@ -167,13 +229,14 @@ public:
 	 * Applies all the shown shapes to a grid
 	 * @param grid grid to be modified
 	 */
-	void fill(Grid<bool>& grid) const;
+	void fill(BitGrid& grid) const;
 	/**
 	 * Sets all points of a grid based on what shapes of this stack they are contained in.
 	 * @param grid grid to be set
-	 * Equivalent to setting all points of the grid to false and then calling this->fill(grid)
+	 * Equivalent to setting all points of the grid to false and then calling this->fill(grid),
+	 * but only rasterizes the shapes that haven't been rasterized at the grid's resolution before (@see ObstacleMaskCache)
 	 */
-	void set(Grid<bool>& grid) const;
+	void set(BitGrid& grid) const;
 };
 
 /**
@@ -181,6 +244,7 @@ public:
  */
 class ObstacleEllipse : public ObstacleShape
 {
+friend Tests;
 private:
 	/// Coordinates of the center of this ellipse
 	vec2d center;
@@ -189,6 +253,12 @@ private:
 	/// Length of the semiaxis parallel to the y axis
 	double yhaxis;
 
+	/**
+	 * @param p point to investigate
+	 * @return true iff the specified point is inside the ellipse (not including its boundary)
+	 */
+	bool inside(vec2d p) const;
+
 public:
 	/**
 	 * Constructs an ObstacleEllipse object representing an ellipse inscribed in a rectangle
@@ -207,7 +277,7 @@ public:
 	ObstacleEllipse(bool negative, const vec2d& center, double xhaxis, double yhaxis);
 
 	void draw(const Cairo::RefPtr<Cairo::Context>& cr) const override;
-	void fill(Grid<bool>& grid) const override;
+	void fill(BitGrid& grid) const override;
 };
 
 /**
@@ -237,7 +307,7 @@ public:
 	ObstaclePolygon(bool negative, const vec<vec2d>& ps);
 
 	void draw(const Cairo::RefPtr<Cairo::Context>& cr) const override;
-	void fill(Grid<bool>& grid) const override;
+	void fill(BitGrid& grid) const override;
 };
 
 /**
@@ -0,0 +1,226 @@
+/**
+ * pressure-solver-cholesky.cpp
+ *
+ * Author: Viktor Fukala
+ * Created on 2026/10/17
+ */
+#include "pressure-solver-cholesky.hpp"
+
+#include <cmath>
+#include <limits>
+
+namespace brandy0
+{
+
+/// Marks the absence of a parent in the elimination tree
+constexpr uint32_t NoParent = std::numeric_limits<uint32_t>::max();
+
+PressureSolverCholesky::PressureSolverCholesky(const double dx, const double dy, const BitGrid &indep, const BitGrid &dirichlet)
+	: rhsCoef(dx * dx * dy * dy)
+{
+	const uint32_t wp = indep.w;
+	const uint32_t hp = indep.h;
+
+	BitGrid unknown = indep;
+	unknown.subtract(dirichlet);
+	// the edges are never unknowns
+	dissect(1, wp - 1, 1, hp - 1, unknown);
+	n = cells.size();
+
+	Grid<uint32_t> index(wp, hp);
+	for (uint32_t k = 0; k < n; k++)
+		index.data[cells[k]] = k;
+
+	// assemble the upper triangle of the (permuted) matrix by columns
+	vec<uint32_t> astart(n + 1);
+	vec<uint32_t> arows;
+	vec<double> avals;
+	arows.reserve(3 * n);
+	avals.reserve(3 * n);
+	for (uint32_t k = 0; k < n; k++)
+	{
+		astart[k] = arows.size();
+		const uint32_t x = cells[k] % wp;
+		const uint32_t y = cells[k] / wp;
+		double coef = 0;
+		auto couple = [&](const uint32_t nx, const uint32_t ny, const double a)
+		{
+			if (unknown(nx, ny))
+			{
+				coef += a;
+				if (index(nx, ny) < k)
+				{
+					arows.push_back(index(nx, ny));
+					avals.push_back(-a);
+				}
+			}
+			else if (dirichlet(nx, ny))
+			{
+				coef += a;
+				dirichletUnknowns.push_back(k);
+				dirichletCells.push_back(nx + ny * wp);
+				dirichletCoefs.push_back(a);
+			}
+		};
+		couple(x + 1, y, dy * dy);
+		couple(x - 1, y, dy * dy);
+		couple(x, y + 1, dx * dx);
+		couple(x, y - 1, dx * dx);
+		arows.push_back(k);
+		avals.push_back(coef);
+	}
+	astart[n] = arows.size();
+
+	// symbolic factorization: the elimination tree and the number of nonzeros in each column of L
+	vec<uint32_t> parent(n), flag(n), count(n);
+	for (uint32_t k = 0; k < n; k++)
+	{
+		parent[k] = NoParent;
+		flag[k] = k;
+		count[k] = 0;
+		for (uint32_t q = astart[k]; q < astart[k + 1]; q++)
+		{
+			// walk from the row index up the elimination tree until reaching a node already visited for this row of L
+			for (uint32_t i = arows[q]; flag[i] != k; i = parent[i])
+			{
+				if (parent[i] == NoParent)
+					parent[i] = k;
+				count[i]++;
+				flag[i] = k;
+			}
+		}
+	}
+	lstart.resize(n + 1);
+	lstart[0] = 0;
+	for (uint32_t k = 0; k < n; k++)
+		lstart[k + 1] = lstart[k] + count[k];
+	lrows.resize(lstart[n]);
+	lvals.resize(lstart[n]);
+	diag.resize(n);
+	work.resize(n);
+
+	// numeric factorization computing L row by row
+	vec<uint32_t> pattern(n);
+	vec<double> &y = work;
+	std::fill(y.begin(), y.end(), 0);
+	for (uint32_t k = 0; k < n; k++)
+	{
+		uint32_t top = n;
+		flag[k] = k;
+		count[k] = 0;
+		for (uint32_t q = astart[k]; q < astart[k + 1]; q++)
+		{
+			uint32_t i = arows[q];
+			y[i] += avals[q];
+			uint32_t len = 0;
+			for (; flag[i] != k; i = parent[i])
+			{
+				pattern[len++] = i;
+				flag[i] = k;
+			}
+			while (len > 0)
+				pattern[--top] = pattern[--len];
+		}
+		diag[k] = y[k];
+		y[k] = 0;
+		for (; top < n; top++)
+		{
+			const uint32_t i = pattern[top];
+			const double yi = y[i];
+			y[i] = 0;
+			const uint64_t end = lstart[i] + count[i];
+			for (uint64_t q = lstart[i]; q < end; q++)
+				y[lrows[q]] -= lvals[q] * yi;
+			const double lki = yi / diag[i];
+			diag[k] -= lki * yi;
+			lrows[end] = k;
+			lvals[end] = lki;
+			count[i]++;
+		}
+	}
+}
+
+void PressureSolverCholesky::dissect(const uint32_t x0, const uint32_t x1, const uint32_t y0, const uint32_t y1, const BitGrid &unknown)
+{
+	if (x0 >= x1 || y0 >= y1)
+		return;
+	const uint32_t w = x1 - x0;
+	const uint32_t h = y1 - y0;
+	if (w * h <= DissectionLeafSize || w < 3 || h < 3)
+	{
+		for (uint32_t y = y0; y < y1; y++)
+		{
+			for (uint32_t x = x0; x < x1; x++)
+			{
+				if (unknown(x, y))
+					cells.push_back(x + y * unknown.w);
+			}
+		}
+		return;
+	}
+	// the 5-point stencil never couples points on different sides of a full row or column,
+	// so the two halves are eliminated independently and the separator last
+	if (w >= h)
+	{
+		const uint32_t mid = x0 + w / 2;
+		dissect(x0, mid, y0, y1, unknown);
+		dissect(mid + 1, x1, y0, y1, unknown);
+		dissect(mid, mid + 1, y0, y1, unknown);
+	}
+	else
+	{
+		const uint32_t mid = y0 + h / 2;
+		dissect(x0, x1, y0, mid, unknown);
+		dissect(x0, x1, mid + 1, y1, unknown);
+		dissect(x0, x1, mid, mid + 1, unknown);
+	}
+}
+
+PressureSolveResult PressureSolverCholesky::solve(Grid<double> &p, const Grid<double> &field, const BoolFunc &)
+{
+	iterationCount++;
+	vec<double> &x = work;
+	for (uint32_t k = 0; k < n; k++)
+		x[k] = -rhsCoef * field.data[cells[k]];
+	for (uint32_t i = 0; i < dirichletUnknowns.size(); i++)
+		x[dirichletUnknowns[i]] += dirichletCoefs[i] * p.data[dirichletCells[i]];
+
+	for (uint32_t j = 0; j < n; j++)
+	{
+		const double xj = x[j];
+		for (uint64_t q = lstart[j]; q < lstart[j + 1]; q++)
+			x[lrows[q]] -= lvals[q] * xj;
+	}
+	for (uint32_t j = 0; j < n; j++)
+		x[j] /= diag[j];
+	for (uint32_t j = n; j-- > 0; )
+	{
+		double xj = x[j];
+		for (uint64_t q = lstart[j]; q < lstart[j + 1]; q++)
+			xj -= lvals[q] * x[lrows[q]];
+		x[j] = xj;
+	}
+
+	for (uint32_t k = 0; k < n; k++)
+	{
+		if (std::isnan(x[k]))
+			return PressureSolveResult::Diverged;
+		p.data[cells[k]] = x[k];
+	}
+	return PressureSolveResult::Converged;
+}
+
+uint64_t PressureSolverCholesky::getMemoryFootprint() const
+{
+	return lstart.capacity() * sizeof(uint64_t)
+		+ lrows.capacity() * sizeof(uint32_t)
+		+ lvals.capacity() * sizeof(double)
+		+ diag.capacity() * sizeof(double)
+		+ work.capacity() * sizeof(double)
+		+ cells.capacity() * sizeof(uint32_t)
+		+ dirichletUnknowns.capacity() * sizeof(uint32_t)
+		+ dirichletCells.capacity() * sizeof(uint32_t)
+		+ dirichletCoefs.capacity() * sizeof(double);
+}
+
+}
@@ -0,0 +1,82 @@
+/**
+ * pressure-solver-cholesky.hpp
+ *
+ * Author: Viktor Fukala
+ * Created on 2026/10/17
+ */
+#ifndef PRESSURE_SOLVER_CHOLESKY_HPP
+#define PRESSURE_SOLVER_CHOLESKY_HPP
+
+#include "pressure-solver.hpp"
+#include "vec.hpp"
+
+namespace brandy0
+{
+
+/**
+ * Direct solver of the Poisson equation for pressure.
+ *
+ * The matrix of the discretized equation depends only on the geometry, which is fixed during the simulation.
+ * Hence, the matrix is assembled and factorized (as L D L^T, L unit lower triangular, D diagonal) once in the constructor
+ * and every solve consists only of one forward and one backward substitution.
+ * The unknowns are ordered by a (geometric) nested dissection to reduce the fill-in of the factor.
+ */
+class PressureSolverCholesky : public PressureSolver
+{
+private:
+	/// Nested dissection stops splitting subdomains with at most this many points and orders their points lexicographically
+	static constexpr uint32_t DissectionLeafSize = 16;
+
+	/// Number of unknowns
+	uint32_t n;
+	/// Product dx^2 * dy^2 multiplying the RHS of the discretized equation
+	double rhsCoef;
+	/// Indices (into Grid::data) of the points corresponding to the unknowns (in the elimination order)
+	vec<uint32_t> cells;
+	/**
+	 * Couplings of the unknowns with Dirichlet points, which contribute to the RHS.
+	 * Each is given by the index of the unknown, the index (into Grid::data) of the Dirichlet point, and the coefficient
+	 */
+	vec<uint32_t> dirichletUnknowns;
+	/// @see dirichletUnknowns
+	vec<uint32_t> dirichletCells;
+	/// @see dirichletUnknowns
+	vec<double> dirichletCoefs;
+	/// Start of each column of L in lrows and lvals (of size n + 1)
+	vec<uint64_t> lstart;
+	/// Row indices of the below-diagonal nonzeros of L (stored by columns)
+	vec<uint32_t> lrows;
+	/// Values of the below-diagonal nonzeros of L (stored by columns)
+	vec<double> lvals;
+	/// Diagonal of D
+	vec<double> diag;
+	/// Work vector for the RHS and the solution
+	vec<double> work;
+
+	/**
+	 * Appends the unknowns inside a rectangle to the elimination order by nested dissection
+	 * @param x0 smallest x index of the rectangle
+	 * @param x1 largest x index of the rectangle plus one
+	 * @param y0 smallest y index of the rectangle
+	 * @param y1 largest y index of the rectangle plus one
+	 * @param unknown grid in which a point is true iff it corresponds to an unknown
+	 */
+	void dissect(uint32_t x0, uint32_t x1, uint32_t y0, uint32_t y1, const BitGrid &unknown);
+
+public:
+	/**
+	 * Assembles and factorizes the matrix of the discretized equation for a fixed geometry
+	 * @param dx spacial step along the x axis
+	 * @param dy spacial step along the y axis
+	 * @param indep grid of independent points (@see Simulator::indep)
+	 * @param dirichlet grid of points with pressure fixed by a Dirichlet condition (@see SimulatorClassic::dirichlet)
+	 */
+	PressureSolverCholesky(double dx, double dy, const BitGrid &indep, const BitGrid &dirichlet);
+
+	PressureSolveResult solve(Grid<double> &p, const Grid<double> &field, const BoolFunc &pauseRequested) override;
+	uint64_t getMemoryFootprint() const override;
+};
+
+}
+
+#endif // PRESSURE_SOLVER_CHOLESKY_HPP
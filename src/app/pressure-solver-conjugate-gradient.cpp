@@ -0,0 +1,238 @@
+/**
+ * pressure-solver-conjugate-gradient.cpp
+ *
+ * Author: Viktor Fukala
+ * Created on 2026/10/17
+ */
+#include "pressure-solver-conjugate-gradient.hpp"
+
+#include <cmath>
+
+namespace brandy0
+{
+
+/**
+ * @return dot product of two vectors of the same size
+ */
+static double dot(const vec<double> &a, const vec<double> &b)
+{
+	double ret = 0;
+	for (uint32_t i = 0; i < a.size(); i++)
+		ret += a[i] * b[i];
+	return ret;
+}
+
+PressureSolverConjugateGradient::PressureSolverConjugateGradient(const double dx, const double dy, const BitGrid &indep, const BitGrid &dirichlet,
+	const double tolerance, const PcgPreconditionerType preconditioner, const uint32_t iterationCap)
+	: rhsCoef(dx * dx * dy * dy), tolerance(tolerance), preconditioner(preconditioner), mgResidual(0, 0), mgCorrection(0, 0), iterationCap(iterationCap)
+{
+	const uint32_t wp = indep.w;
+	const uint32_t hp = indep.h;
+
+	Grid<uint32_t> index(wp, hp);
+	for (uint32_t y = 1; y < hp - 1; y++)
+	{
+		for (uint32_t x = 1; x < wp - 1; x++)
+		{
+			if (indep(x, y) && !dirichlet(x, y))
+			{
+				index(x, y) = cells.size();
+				cells.push_back(x + y * wp);
+			}
+		}
+	}
+	n = cells.size();
+
+	rowStart.resize(n + 1);
+	diag.resize(n);
+	for (uint32_t k = 0; k < n; k++)
+	{
+		rowStart[k] = cols.size();
+		const uint32_t x = cells[k] % wp;
+		const uint32_t y = cells[k] / wp;
+		double coef = 0;
+		// visited in the order of increasing index so that the columns in each row are sorted
+		auto couple = [&](const uint32_t nx, const uint32_t ny, const double a)
+		{
+			if (indep(nx, ny) && !dirichlet(nx, ny))
+			{
+				coef += a;
+				cols.push_back(index(nx, ny));
+				vals.push_back(-a);
+			}
+			else if (dirichlet(nx, ny))
+			{
+				coef += a;
+				dirichletUnknowns.push_back(k);
+				dirichletCells.push_back(nx + ny * wp);
+				dirichletCoefs.push_back(a);
+			}
+		};
+		couple(x, y - 1, dx * dx);
+		couple(x - 1, y, dy * dy);
+		couple(x + 1, y, dy * dy);
+		couple(x, y + 1, dx * dx);
+		diag[k] = coef;
+	}
+	rowStart[n] = cols.size();
+
+	if (preconditioner == PcgPreconditionerType::PcgIncompleteCholesky)
+	{
+		// for the 5-point stencil, the zero fill-in incomplete Cholesky factorization only modifies the diagonal
+		icPivots.resize(n);
+		for (uint32_t k = 0; k < n; k++)
+		{
+			double piv = diag[k];
+			for (uint32_t i = rowStart[k]; i < rowStart[k + 1] && cols[i] < k; i++)
+				piv -= vals[i] * vals[i] / icPivots[cols[i]];
+			icPivots[k] = piv;
+		}
+	}
+	else if (preconditioner == PcgPreconditionerType::PcgMultigrid)
+	{
+		// only the V-cycles of the multigrid solver are used, not its solve, so the limit and the cap don't matter
+		multigrid = make_unique<PressureSolverMultigrid>(dx, dy, indep, dirichlet, 0, 1);
+		mgResidual = Grid<double>(wp, hp);
+		mgCorrection = Grid<double>(wp, hp);
+		mgResidual.set_all(0);
+	}
+
+	x.resize(n);
+	r.resize(n);
+	z.resize(n);
+	d.resize(n);
+	q.resize(n);
+}
+
+void PressureSolverConjugateGradient::multiply(const vec<double> &v, vec<double> &out) const
+{
+	for (uint32_t k = 0; k < n; k++)
+	{
+		double sm = diag[k] * v[k];
+		for (uint32_t i = rowStart[k]; i < rowStart[k + 1]; i++)
+			sm += vals[i] * v[cols[i]];
+		out[k] = sm;
+	}
+}
+
+void PressureSolverConjugateGradient::precondition(const vec<double> &res, vec<double> &out)
+{
+	if (preconditioner == PcgPreconditionerType::PcgJacobi)
+	{
+		for (uint32_t k = 0; k < n; k++)
+			out[k] = res[k] / diag[k];
+	}
+	else if (preconditioner == PcgPreconditionerType::PcgIncompleteCholesky)
+	{
+		// solve (D + L) D^-1 (D + L^T) out = res, where D are the pivots and L the strictly lower triangle of the operator
+		for (uint32_t k = 0; k < n; k++)
+		{
+			double sm = res[k];
+			for (uint32_t i = rowStart[k]; i < rowStart[k + 1] && cols[i] < k; i++)
+				sm -= vals[i] * out[cols[i]];
+			out[k] = sm / icPivots[k];
+		}
+		for (uint32_t k = n; k-- > 0; )
+		{
+			double sm = 0;
+			for (uint32_t i = rowStart[k + 1]; i-- > rowStart[k] && cols[i] > k; )
+				sm += vals[i] * out[cols[i]];
+			out[k] -= sm / icPivots[k];
+		}
+	}
+	else
+	{
+		// one V-cycle (with symmetric smoothing, so that the preconditioner is symmetric) from the zero initial guess
+		for (uint32_t k = 0; k < n; k++)
+			mgResidual.data[cells[k]] = res[k];
+		multigrid->precondition(mgResidual, mgCorrection);
+		for (uint32_t k = 0; k < n; k++)
+			out[k] = mgCorrection.data[cells[k]];
+	}
+}
+
+void PressureSolverConjugateGradient::store(Grid<double> &p) const
+{
+	for (uint32_t k = 0; k < n; k++)
+		p.data[cells[k]] = x[k];
+}
+
+PressureSolveResult PressureSolverConjugateGradient::solve(Grid<double> &p, const Grid<double> &field, const BoolFunc &pauseRequested)
+{
+	if (!interrupted)
+	{
+		// start from the current pressure field
+		for (uint32_t k = 0; k < n; k++)
+		{
+			r[k] = -rhsCoef * field.data[cells[k]];
+			x[k] = p.data[cells[k]];
+		}
+		for (uint32_t i = 0; i < dirichletUnknowns.size(); i++)
+			r[dirichletUnknowns[i]] += dirichletCoefs[i] * p.data[dirichletCells[i]];
+		rhsNorm = std::sqrt(dot(r, r));
+		multiply(x, q);
+		for (uint32_t k = 0; k < n; k++)
+			r[k] -= q[k];
+		// no nonzero residual is within a tolerance relative to a zero RHS, so the initial residual is reduced instead
+		if (rhsNorm == 0)
+			rhsNorm = std::sqrt(dot(r, r));
+		precondition(r, z);
+		d = z;
+		rz = dot(r, z);
+		solveIterations = 0;
+	}
+	interrupted = false;
+
+	for (uint32_t it = 1; ; it++)
+	{
+		const double rnorm = std::sqrt(dot(r, r));
+		if (std::isnan(rnorm))
+			return PressureSolveResult::Diverged;
+		if (rnorm <= tolerance * rhsNorm)
+		{
+			store(p);
+			return PressureSolveResult::Converged;
+		}
+
+		multiply(d, q);
+		const double alpha = rz / dot(d, q);
+		for (uint32_t k = 0; k < n; k++)
+		{
+			x[k] += alpha * d[k];
+			r[k] -= alpha * q[k];
+		}
+		precondition(r, z);
+		const double rzNew = dot(r, z);
+		const double beta = rzNew / rz;
+		rz = rzNew;
+		for (uint32_t k = 0; k < n; k++)
+			d[k] = z[k] + beta * d[k];
+		iterationCount++;
+		solveIterations++;
+
+		// the cap bounds the time of a step at the cost of the accuracy of the pressure
+		if (solveIterations >= iterationCap)
+		{
+			store(p);
+			return PressureSolveResult::IterationCapReached;
+		}
+		if (it % PauseCheckPeriod == 0 && pauseRequested())
+		{
+			store(p);
+			interrupted = true;
+			return PressureSolveResult::Interrupted;
+		}
+	}
+}
+
+uint64_t PressureSolverConjugateGradient::getMemoryFootprint() const
+{
+	uint64_t ret = (cells.capacity() + rowStart.capacity() + cols.capacity() + dirichletUnknowns.capacity() + dirichletCells.capacity()) * sizeof(uint32_t)
+		+ (vals.capacity() + diag.capacity() + dirichletCoefs.capacity() + icPivots.capacity()) * sizeof(double)
+		+ (x.capacity() + r.capacity() + z.capacity() + d.capacity() + q.capacity()) * sizeof(double);
+	if (multigrid)
+		ret += multigrid->getMemoryFootprint() + 2 * uint64_t(mgResidual.w) * mgResidual.h * sizeof(double);
+	return ret;
+}
+
+}
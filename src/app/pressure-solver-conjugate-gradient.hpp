@@ -0,0 +1,124 @@
+/**
+ * pressure-solver-conjugate-gradient.hpp
+ *
+ * Author: Viktor Fukala
+ * Created on 2026/10/17
+ */
+#ifndef PRESSURE_SOLVER_CONJUGATE_GRADIENT_HPP
+#define PRESSURE_SOLVER_CONJUGATE_GRADIENT_HPP
+
+#include "pressure-solver.hpp"
+#include "pressure-solver-multigrid.hpp"
+#include "ptr.hpp"
+#include "vec.hpp"
+
+namespace brandy0
+{
+
+/**
+ * Preconditioned conjugate gradient solver of the Poisson equation for pressure.
+ *
+ * The iteration stops when the L2 norm of the residual drops below a given fraction of the L2 norm of the RHS.
+ * The state of the iteration is kept when the solving is interrupted, so the next call to solve continues where the previous one stopped.
+ */
+class PressureSolverConjugateGradient : public PressureSolver
+{
+private:
+	/// Number of iterations between two consecutive checks of a pause request
+	static constexpr uint32_t PauseCheckPeriod = 16;
+
+	/// Number of unknowns
+	uint32_t n;
+	/// Product dx^2 * dy^2 multiplying the RHS of the discretized equation
+	double rhsCoef;
+	/// Upper bound on the ratio of the L2 norms of the residual and of the RHS for the solution to be considered converged
+	double tolerance;
+	/// Used preconditioner
+	PcgPreconditionerType preconditioner;
+
+	/// Indices (into Grid::data) of the points corresponding to the unknowns (in the lexicographic order)
+	vec<uint32_t> cells;
+	/// Start of the off-diagonal coefficients of each row in cols and vals (of size n + 1)
+	vec<uint32_t> rowStart;
+	/// Columns of the off-diagonal coefficients (sorted within each row)
+	vec<uint32_t> cols;
+	/// Off-diagonal coefficients
+	vec<double> vals;
+	/// Diagonal coefficients
+	vec<double> diag;
+	/// Couplings of the unknowns with Dirichlet points (same structure as in PressureSolverCholesky)
+	vec<uint32_t> dirichletUnknowns;
+	/// @see dirichletUnknowns
+	vec<uint32_t> dirichletCells;
+	/// @see dirichletUnknowns
+	vec<double> dirichletCoefs;
+
+	/// Pivots of the incomplete Cholesky factorization (empty unless it's the used preconditioner)
+	vec<double> icPivots;
+	/// Multigrid hierarchy used for preconditioning by a single V-cycle (null unless it's the used preconditioner)
+	uptr<PressureSolverMultigrid> multigrid;
+	/// Work grid for the residual passed to the multigrid preconditioner
+	Grid<double> mgResidual;
+	/// Work grid for the correction computed by the multigrid preconditioner
+	Grid<double> mgCorrection;
+
+	/// Current approximation of the solution
+	vec<double> x;
+	/// Current residual
+	vec<double> r;
+	/// Current preconditioned residual
+	vec<double> z;
+	/// Current search direction
+	vec<double> d;
+	/// Product of the operator and the search direction
+	vec<double> q;
+	/// Dot product of r and z
+	double rz;
+	/// L2 norm of the RHS (or of the initial residual if the RHS is zero), to which the norm of the residual is compared
+	double rhsNorm;
+	/// True iff the last call to solve was interrupted (and the iteration state is kept for the next call)
+	bool interrupted = false;
+	/// Cap on the number of iterations in one solving (counted across the interruptions)
+	uint32_t iterationCap;
+	/// Number of iterations performed in the current solving
+	uint32_t solveIterations = 0;
+
+	/**
+	 * Computes the product of the operator with a vector
+	 * @param v vector to multiply
+	 * @param out vector to write the product to
+	 */
+	void multiply(const vec<double> &v, vec<double> &out) const;
+	/**
+	 * Applies the preconditioner to a residual
+	 * @param res the residual
+	 * @param out vector to write the preconditioned residual to
+	 */
+	void precondition(const vec<double> &res, vec<double> &out);
+	/**
+	 * Writes the current approximation of the solution to a pressure field
+	 * @param p pressure field to write to
+	 */
+	void store(Grid<double> &p) const;
+
+public:
+	/**
+	 * Assembles the operator and sets up the preconditioner for a fixed geometry
+	 * @param dx spacial step along the x axis
+	 * @param dy spacial step along the y axis
+	 * @param indep grid of independent points (@see Simulator::indep)
+	 * @param dirichlet grid of points with pressure fixed by a Dirichlet condition (@see SimulatorClassic::dirichlet)
+	 * @param tolerance upper bound on the ratio of the L2 norms of the residual and of the RHS (of the initial residual if the RHS is zero) for the solution to be considered converged
+	 * @param preconditioner preconditioner to use
+	 * @param iterationCap cap on the number of iterations in one solving
+	 */
+	PressureSolverConjugateGradient(double dx, double dy, const BitGrid &indep, const BitGrid &dirichlet, double tolerance, PcgPreconditionerType preconditioner,
+		uint32_t iterationCap);
+
+	PressureSolveResult solve(Grid<double> &p, const Grid<double> &field, const BoolFunc &pauseRequested) override;
+	uint64_t getMemoryFootprint() const override;
+};
+
+}
+
+#endif // PRESSURE_SOLVER_CONJUGATE_GRADIENT_HPP
@@ -0,0 +1,371 @@
+/**
+ * pressure-solver-multigrid.cpp
+ *
+ * Author: Viktor Fukala
+ * Created on 2026/10/17
+ */
+#include "pressure-solver-multigrid.hpp"
+
+#include <cmath>
+
+namespace brandy0
+{
+
+PressureSolverMultigrid::Level::Level(const uint32_t w, const uint32_t h, const bool ninePoint)
+	: w(w), h(h), c(w, h), e(w, h), n(w, h), ne(ninePoint ? w : 0, ninePoint ? h : 0), nw(ninePoint ? w : 0, ninePoint ? h : 0),
+	x(w, h), b(w, h), r(w, h)
+{
+	c.set_all(0);
+	e.set_all(0);
+	n.set_all(0);
+	ne.set_all(0);
+	nw.set_all(0);
+	x.set_all(0);
+	b.set_all(0);
+	r.set_all(0);
+}
+
+PressureSolverMultigrid::PressureSolverMultigrid(const double dx, const double dy, const BitGrid &indep, const BitGrid &dirichlet, const double l1limit,
+	const uint32_t iterationCap)
+	: rhsCoef(dx * dx * dy * dy), l1limit(l1limit), iterationCap(iterationCap)
+{
+	const uint32_t wp = indep.w;
+	const uint32_t hp = indep.h;
+
+	// the levels are never copied, so reserve enough space for all of them at once
+	uint32_t levelCount = 1;
+	for (uint32_t w = wp, h = hp; w / 2 + 2 < w || h / 2 + 2 < h; w = std::min(w, w / 2 + 2), h = std::min(h, h / 2 + 2))
+		levelCount++;
+	levels.reserve(levelCount);
+
+	// the finest level has the 5-point stencil of the original discretization
+	// (including the coefficients towards Dirichlet points, which are not unknowns, but whose values are read from the pressure field)
+	levels.emplace_back(wp, hp, false);
+	Level &f = levels.back();
+	auto valid = [&indep, &dirichlet](const uint32_t x, const uint32_t y) { return indep(x, y) || dirichlet(x, y); };
+	for (uint32_t y = 0; y < hp; y++)
+	{
+		for (uint32_t x = 0; x < wp; x++)
+		{
+			if (x + 1 < wp && valid(x, y) && valid(x + 1, y))
+				f.e(x, y) = -dy * dy;
+			if (y + 1 < hp && valid(x, y) && valid(x, y + 1))
+				f.n(x, y) = -dx * dx;
+		}
+	}
+	for (uint32_t y = 1; y < hp - 1; y++)
+	{
+		for (uint32_t x = 1; x < wp - 1; x++)
+		{
+			if (indep(x, y) && !dirichlet(x, y))
+				f.c(x, y) = -(f.e(x, y) + f.e(x - 1, y) + f.n(x, y) + f.n(x, y - 1));
+		}
+	}
+
+	while (true)
+	{
+		const Level &l = levels.back();
+		uint32_t active = 0;
+		for (uint32_t i = 0; i < l.w * l.h; i++)
+		{
+			if (l.c.data[i] > 0)
+				active++;
+		}
+		if (active <= CoarsestMaxActive || levels.size() == levelCount)
+			break;
+		addCoarseLevel();
+	}
+}
+
+/**
+ * Finds the points of a coarser grid that a point of a finer grid is interpolated from (along one axis).
+ * The coarse point with index i lies at the fine point with index 2 * i - 1.
+ * @param a index of the fine point
+ * @param parents array to write the indices of the coarse points to
+ * @param weights array to write the interpolation weights of the coarse points to
+ * @return number of coarse points the fine point is interpolated from (1 or 2)
+ */
+static uint32_t coarseParents(const uint32_t a, uint32_t *const parents, double *const weights)
+{
+	if (a % 2 == 1)
+	{
+		parents[0] = (a + 1) / 2;
+		weights[0] = 1;
+		return 1;
+	}
+	parents[0] = a / 2;
+	parents[1] = a / 2 + 1;
+	weights[0] = weights[1] = .5;
+	return 2;
+}
+
+void PressureSolverMultigrid::addCoarseLevel()
+{
+	const bool fromFinest = levels.size() == 1;
+	levels.emplace_back(levels.back().w / 2 + 2, levels.back().h / 2 + 2, true);
+	const Level &f = levels[levels.size() - 2];
+	Level &co = levels.back();
+
+	for (uint32_t y = 1; y < f.h - 1; y++)
+	{
+		for (uint32_t x = 1; x < f.w - 1; x++)
+		{
+			if (f.c(x, y) <= 0)
+				continue;
+
+			// the couplings of this fine point with active fine points (including itself)
+			int32_t offx[9], offy[9];
+			double coef[9];
+			uint32_t cou = 0;
+			auto addCoupling = [&](const int32_t ox, const int32_t oy, const double a)
+			{
+				if (a != 0 && f.c(x + ox, y + oy) > 0)
+				{
+					offx[cou] = ox;
+					offy[cou] = oy;
+					coef[cou] = a;
+					cou++;
+				}
+			};
+			addCoupling(0, 0, f.c(x, y));
+			addCoupling(1, 0, f.e(x, y));
+			addCoupling(-1, 0, f.e(x - 1, y));
+			addCoupling(0, 1, f.n(x, y));
+			addCoupling(0, -1, f.n(x, y - 1));
+			if (!fromFinest)
+			{
+				addCoupling(1, 1, f.ne(x, y));
+				addCoupling(-1, -1, f.ne(x - 1, y - 1));
+				addCoupling(-1, 1, f.nw(x, y));
+				addCoupling(1, -1, f.nw(x + 1, y - 1));
+			}
+
+			uint32_t ipx[2], ipy[2];
+			double iwx[2], iwy[2];
+			const uint32_t icx = coarseParents(x, ipx, iwx);
+			const uint32_t icy = coarseParents(y, ipy, iwy);
+			for (uint32_t k = 0; k < cou; k++)
+			{
+				uint32_t jpx[2], jpy[2];
+				double jwx[2], jwy[2];
+				const uint32_t jcx = coarseParents(x + offx[k], jpx, jwx);
+				const uint32_t jcy = coarseParents(y + offy[k], jpy, jwy);
+				for (uint32_t iy = 0; iy < icy; iy++)
+				for (uint32_t ix = 0; ix < icx; ix++)
+				for (uint32_t jy = 0; jy < jcy; jy++)
+				for (uint32_t jx = 0; jx < jcx; jx++)
+				{
+					// only the diagonal and the forward coefficients are stored, the backward ones are their symmetric counterparts
+					const double val = iwx[ix] * iwy[iy] * coef[k] * jwx[jx] * jwy[jy];
+					const int32_t ox = int32_t(jpx[jx]) - int32_t(ipx[ix]);
+					const int32_t oy = int32_t(jpy[jy]) - int32_t(ipy[iy]);
+					const uint32_t cx = ipx[ix], cy = ipy[iy];
+					if (oy == 0 && ox == 0)
+						co.c(cx, cy) += val;
+					else if (oy == 0 && ox == 1)
+						co.e(cx, cy) += val;
+					else if (oy == 1 && ox == 0)
+						co.n(cx, cy) += val;
+					else if (oy == 1 && ox == 1)
+						co.ne(cx, cy) += val;
+					else if (oy == 1 && ox == -1)
+						co.nw(cx, cy) += val;
+				}
+			}
+		}
+	}
+}
+
+template <bool NinePoint>
+void PressureSolverMultigrid::smooth(Level &l, Grid<double> &x, const Grid<double> &b, const bool forward, const uint32_t sweeps)
+{
+	auto relax = [&l, &x, &b](const uint32_t i, const uint32_t j)
+	{
+		if (l.c(i, j) <= 0)
+			return;
+		double sm = b(i, j)
+			- l.e(i, j) * x(i + 1, j) - l.e(i - 1, j) * x(i - 1, j)
+			- l.n(i, j) * x(i, j + 1) - l.n(i, j - 1) * x(i, j - 1);
+		if (NinePoint)
+		{
+			sm -= l.ne(i, j) * x(i + 1, j + 1) + l.ne(i - 1, j - 1) * x(i - 1, j - 1)
+				+ l.nw(i, j) * x(i - 1, j + 1) + l.nw(i + 1, j - 1) * x(i + 1, j - 1);
+		}
+		x(i, j) = sm / l.c(i, j);
+	};
+	for (uint32_t s = 0; s < sweeps; s++)
+	{
+		if (forward)
+		{
+			for (uint32_t j = 1; j < l.h - 1; j++)
+				for (uint32_t i = 1; i < l.w - 1; i++)
+					relax(i, j);
+		}
+		else
+		{
+			for (uint32_t j = l.h - 2; j >= 1; j--)
+				for (uint32_t i = l.w - 2; i >= 1; i--)
+					relax(i, j);
+		}
+	}
+}
+
+template <bool NinePoint>
+void PressureSolverMultigrid::computeResidual(Level &l, const Grid<double> &x, const Grid<double> &b)
+{
+	for (uint32_t j = 1; j < l.h - 1; j++)
+	{
+		for (uint32_t i = 1; i < l.w - 1; i++)
+		{
+			if (l.c(i, j) <= 0)
+				continue;
+			double res = b(i, j) - l.c(i, j) * x(i, j)
+				- l.e(i, j) * x(i + 1, j) - l.e(i - 1, j) * x(i - 1, j)
+				- l.n(i, j) * x(i, j + 1) - l.n(i, j - 1) * x(i, j - 1);
+			if (NinePoint)
+			{
+				res -= l.ne(i, j) * x(i + 1, j + 1) + l.ne(i - 1, j - 1) * x(i - 1, j - 1)
+					+ l.nw(i, j) * x(i - 1, j + 1) + l.nw(i + 1, j - 1) * x(i + 1, j - 1);
+			}
+			l.r(i, j) = res;
+		}
+	}
+}
+
+void PressureSolverMultigrid::vcycle(const uint32_t li, Grid<double> &x, const Grid<double> &b)
+{
+	Level &l = levels[li];
+	const bool ninePoint = li != 0;
+	if (li + 1 == levels.size())
+	{
+		for (uint32_t s = 0; s < CoarsestSweeps; s++)
+		{
+			if (ninePoint)
+			{
+				smooth<true>(l, x, b, true, 1);
+				smooth<true>(l, x, b, false, 1);
+			}
+			else
+			{
+				smooth<false>(l, x, b, true, 1);
+				smooth<false>(l, x, b, false, 1);
+			}
+		}
+		return;
+	}
+
+	if (ninePoint)
+	{
+		smooth<true>(l, x, b, true, SmoothingSweeps);
+		computeResidual<true>(l, x, b);
+	}
+	else
+	{
+		smooth<false>(l, x, b, true, SmoothingSweeps);
+		computeResidual<false>(l, x, b);
+	}
+
+	// restrict the residual to the coarser level (by the transpose of the interpolation)
+	Level &co = levels[li + 1];
+	co.b.set_all(0);
+	co.x.set_all(0);
+	for (uint32_t j = 1; j < l.h - 1; j++)
+	{
+		for (uint32_t i = 1; i < l.w - 1; i++)
+		{
+			if (l.c(i, j) <= 0)
+				continue;
+			uint32_t px[2], py[2];
+			double wx[2], wy[2];
+			const uint32_t cx = coarseParents(i, px, wx);
+			const uint32_t cy = coarseParents(j, py, wy);
+			for (uint32_t ky = 0; ky < cy; ky++)
+				for (uint32_t kx = 0; kx < cx; kx++)
+					co.b(px[kx], py[ky]) += wx[kx] * wy[ky] * l.r(i, j);
+		}
+	}
+
+	vcycle(li + 1, co.x, co.b);
+
+	// interpolate the coarse correction back to this level
+	for (uint32_t j = 1; j < l.h - 1; j++)
+	{
+		for (uint32_t i = 1; i < l.w - 1; i++)
+		{
+			if (l.c(i, j) <= 0)
+				continue;
+			uint32_t px[2], py[2];
+			double wx[2], wy[2];
+			const uint32_t cx = coarseParents(i, px, wx);
+			const uint32_t cy = coarseParents(j, py, wy);
+			for (uint32_t ky = 0; ky < cy; ky++)
+				for (uint32_t kx = 0; kx < cx; kx++)
+					x(i, j) += wx[kx] * wy[ky] * co.x(px[kx], py[ky]);
+		}
+	}
+
+	if (ninePoint)
+		smooth<true>(l, x, b, false, SmoothingSweeps);
+	else
+		smooth<false>(l, x, b, false, SmoothingSweeps);
+}
+
+PressureSolveResult PressureSolverMultigrid::solve(Grid<double> &p, const Grid<double> &field, const BoolFunc &pauseRequested)
+{
+	Level &f = levels.front();
+	for (uint32_t y = 1; y < f.h - 1; y++)
+	{
+		for (uint32_t x = 1; x < f.w - 1; x++)
+		{
+			if (f.c(x, y) > 0)
+				f.b(x, y) = -rhsCoef * field(x, y);
+		}
+	}
+	if (!interrupted)
+		solveIterations = 0;
+	interrupted = false;
+	while (true)
+	{
+		f.x = p;
+		vcycle(0, p, f.b);
+		iterationCount++;
+		solveIterations++;
+		double dl1 = 0;
+		for (uint32_t y = 1; y < f.h - 1; y++)
+		{
+			for (uint32_t x = 1; x < f.w - 1; x++)
+			{
+				if (f.c(x, y) > 0)
+					dl1 += std::abs(p(x, y) - f.x(x, y));
+			}
+		}
+		if (std::isnan(dl1))
+			return PressureSolveResult::Diverged;
+		if (dl1 < l1limit)
+			return PressureSolveResult::Converged;
+		// the cap bounds the time of a step at the cost of the accuracy of the pressure
+		if (solveIterations >= iterationCap)
+			return PressureSolveResult::IterationCapReached;
+		if (pauseRequested())
+		{
+			interrupted = true;
+			return PressureSolveResult::Interrupted;
+		}
+	}
+}
+
+void PressureSolverMultigrid::precondition(const Grid<double> &b, Grid<double> &x)
+{
+	x.set_all(0);
+	vcycle(0, x, b);
+}
+
+uint64_t PressureSolverMultigrid::getMemoryFootprint() const
+{
+	uint64_t ret = 0;
+	for (const Level &l : levels)
+		ret += (l.ne.w * l.ne.h + l.nw.w * l.nw.h + 6 * l.w * l.h) * sizeof(double);
+	return ret;
+}
+
+}
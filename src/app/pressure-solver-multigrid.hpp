@@ -0,0 +1,143 @@
+/**
+ * pressure-solver-multigrid.hpp
+ *
+ * Author: Viktor Fukala
+ * Created on 2026/10/17
+ */
+#ifndef PRESSURE_SOLVER_MULTIGRID_HPP
+#define PRESSURE_SOLVER_MULTIGRID_HPP
+
+#include "pressure-solver.hpp"
+#include "vec.hpp"
+
+namespace brandy0
+{
+
+/**
+ * Geometric multigrid solver of the Poisson equation for pressure.
+ *
+ * Solves by V-cycles with Gauss-Seidel smoothing (forward before, backward after the coarse grid correction).
+ * The coarse grids have every other point of the finer grid, the interpolation between them is bilinear,
+ * and the coarse operators are computed as the Galerkin products (R A P) of the finer operators.
+ * That way, the coarse operators automatically follow the shape of the (generally non-rectangular) fluid domain
+ * and of the Dirichlet points.
+ */
+class PressureSolverMultigrid : public PressureSolver
+{
+private:
+	/**
+	 * One level (one grid) of the multigrid hierarchy.
+	 * The (symmetric, at most 9-point) operator of the level is stored as its diagonal
+	 * and its coefficients towards the right, top, top right, and top left neighbors
+	 * (the coefficients towards the other four neighbors follow from the symmetry).
+	 * A point is active (it is an unknown) iff its diagonal coefficient is positive.
+	 * The points at the edges of each level are never active.
+	 */
+	struct Level
+	{
+		/// Width of the level's grid
+		uint32_t w;
+		/// Height of the level's grid
+		uint32_t h;
+		/// Diagonal coefficients
+		Grid<double> c;
+		/// Coefficients towards the right neighbors
+		Grid<double> e;
+		/// Coefficients towards the top neighbors
+		Grid<double> n;
+		/// Coefficients towards the top right neighbors (empty at the finest level, which has a 5-point stencil)
+		Grid<double> ne;
+		/// Coefficients towards the top left neighbors (empty at the finest level, which has a 5-point stencil)
+		Grid<double> nw;
+		/// Approximation of the solution (at the finest level used to store the previous approximation instead)
+		Grid<double> x;
+		/// RHS
+		Grid<double> b;
+		/// Residual
+		Grid<double> r;
+
+		/**
+		 * Constructs a Level object with all coefficients set to zero
+		 * @param w width of the level's grid
+		 * @param h height of the level's grid
+		 * @param ninePoint true iff the level's operator can have the diagonal coefficients (false only for the finest level)
+		 */
+		Level(uint32_t w, uint32_t h, bool ninePoint);
+	};
+
+	/// Number of smoothing sweeps before and after each coarse grid correction
+	static constexpr uint32_t SmoothingSweeps = 2;
+	/// Number of symmetric pairs of smoothing sweeps used to solve the equation at the coarsest level
+	static constexpr uint32_t CoarsestSweeps = 32;
+	/// Maximum number of active points at a level for it to be used as the coarsest level
+	static constexpr uint32_t CoarsestMaxActive = 64;
+
+	/// Levels of the hierarchy from the finest (the original grid) to the coarsest
+	vec<Level> levels;
+	/// Product dx^2 * dy^2 multiplying the RHS of the discretized equation
+	double rhsCoef;
+	/// Upper bound on the L1 norm of the change of pressure during one V-cycle for the solution to be considered converged
+	double l1limit;
+	/// Cap on the number of V-cycles in one solving (counted across the interruptions)
+	uint32_t iterationCap;
+	/// Number of V-cycles performed in the current solving
+	uint32_t solveIterations = 0;
+	/// True iff the last call to solve was interrupted (so the next call continues the same solving)
+	bool interrupted = false;
+
+	/**
+	 * Appends a new coarsest level to the hierarchy by computing the Galerkin product of the current coarsest level
+	 */
+	void addCoarseLevel();
+	/**
+	 * Performs Gauss-Seidel sweeps at a level
+	 * @param l index of the level
+	 * @param x approximation of the solution to improve
+	 * @param b RHS
+	 * @param forward true iff the points should be visited in the lexicographic order (otherwise they're visited in the reverse order)
+	 * @param sweeps number of sweeps
+	 */
+	template <bool NinePoint>
+	void smooth(Level &l, Grid<double> &x, const Grid<double> &b, bool forward, uint32_t sweeps);
+	/**
+	 * Computes the residual at a level and stores it in l.r
+	 * @param l the level
+	 * @param x approximation of the solution
+	 * @param b RHS
+	 */
+	template <bool NinePoint>
+	void computeResidual(Level &l, const Grid<double> &x, const Grid<double> &b);
+	/**
+	 * Performs one V-cycle
+	 * @param li index of the level to start the cycle at
+	 * @param x approximation of the solution at that level to improve
+	 * @param b RHS at that level
+	 */
+	void vcycle(uint32_t li, Grid<double> &x, const Grid<double> &b);
+
+public:
+	/**
+	 * Constructs the multigrid hierarchy for a fixed geometry
+	 * @param dx spacial step along the x axis
+	 * @param dy spacial step along the y axis
+	 * @param indep grid of independent points (@see Simulator::indep)
+	 * @param dirichlet grid of points with pressure fixed by a Dirichlet condition (@see SimulatorClassic::dirichlet)
+	 * @param l1limit upper bound on the L1 norm of the change of pressure during one V-cycle for the solution to be considered converged
+	 * @param iterationCap cap on the number of V-cycles in one solving
+	 */
+	PressureSolverMultigrid(double dx, double dy, const BitGrid &indep, const BitGrid &dirichlet, double l1limit, uint32_t iterationCap);
+
+	PressureSolveResult solve(Grid<double> &p, const Grid<double> &field, const BoolFunc &pauseRequested) override;
+	/**
+	 * Approximately solves the equation with a given (already scaled) RHS by one V-cycle from the zero initial guess.
+	 * The mapping from the RHS to the result is linear and symmetric, so it can be used as a preconditioner.
+	 * @param b RHS (the values at the points that are not unknowns are ignored)
+	 * @param x grid to write the result to (zero at the points that are not unknowns)
+	 */
+	void precondition(const Grid<double> &b, Grid<double> &x);
+	uint64_t getMemoryFootprint() const override;
+};
+
+}
+
+#endif // PRESSURE_SOLVER_MULTIGRID_HPP
@@ -0,0 +1,397 @@
+/**
+ * pressure-solver-spectral.cpp
+ *
+ * Author: Viktor Fukala
+ * Created on 2026/10/17
+ */
+#include "pressure-solver-spectral.hpp"
+
+#include <cmath>
+
+namespace brandy0
+{
+
+namespace
+{
+
+/**
+ * Describes the eigenvectors of the one-dimensional discrete Laplacian on the inner points 1, ..., m of a line
+ * as phi_k(i) = trig(pi * (k + c) * (i + b) / d) for k = 0, ..., m - 1 with the eigenvalues 2 - 2 cos(pi * (k + c) / d).
+ * At a Dirichlet end, the operator couples to the (fixed) end point, at a Neumann end, the coupling is omitted.
+ */
+struct AxisBasis
+{
+	/// True iff trig is sin (otherwise it's cos)
+	bool sine;
+	/// Offset of the point index
+	double b;
+	/// Offset of the eigenvector index
+	double c;
+	/// Period parameter
+	double d;
+
+	/**
+	 * Constructs the description of the eigenvectors for the given types of the conditions at the ends
+	 * @param m number of inner points
+	 * @param lowDirichlet true iff there is a Dirichlet condition at the low end (otherwise Neumann)
+	 * @param highDirichlet true iff there is a Dirichlet condition at the high end (otherwise Neumann)
+	 */
+	AxisBasis(const uint32_t m, const bool lowDirichlet, const bool highDirichlet)
+	{
+		sine = lowDirichlet;
+		b = lowDirichlet ? 0 : -.5;
+		if (lowDirichlet == highDirichlet)
+		{
+			c = lowDirichlet ? 1 : 0;
+			d = lowDirichlet ? m + 1 : m;
+		}
+		else
+		{
+			c = .5;
+			d = m + .5;
+		}
+	}
+
+	/// @return the transform from values to the coefficients of the eigenvectors
+	TrigTransform analysis(const uint32_t m) const
+	{
+		return TrigTransform(m, 1 + b, c, d, sine);
+	}
+
+	/// @return the transform from the coefficients of the eigenvectors to values
+	TrigTransform synthesis(const uint32_t m) const
+	{
+		return TrigTransform(m, c, 1 + b, d, sine);
+	}
+
+	/// @return the eigenvalue of the k-th eigenvector
+	double eigenvalue(const uint32_t k) const
+	{
+		return 2 - 2 * std::cos(M_PI * (k + c) / d);
+	}
+
+	/// @return the squared norm of the k-th eigenvector
+	double squaredNorm(const uint32_t m, const uint32_t k) const
+	{
+		double ret = 0;
+		for (uint32_t i = 1; i <= m; i++)
+		{
+			const double val = sine ? std::sin(M_PI * (k + c) * (i + b) / d) : std::cos(M_PI * (k + c) * (i + b) / d);
+			ret += val * val;
+		}
+		return ret;
+	}
+};
+
+}
+
+/**
+ * Checks whether the row of the operator at an inner point differs from the row of the operator without obstacles.
+ * That is iff the point is a Dirichlet point or it is an unknown with a neighboring inner point that is neither independent nor Dirichlet
+ * @param x x index of the point
+ * @param y y index of the point
+ * @param indep grid of independent points
+ * @param dirichlet grid of Dirichlet points
+ * @return true iff the row differs
+ */
+static bool isRowChanged(const uint32_t x, const uint32_t y, const BitGrid &indep, const BitGrid &dirichlet)
+{
+	if (dirichlet(x, y))
+		return true;
+	if (!indep(x, y))
+		return false;
+	auto excluded = [&indep, &dirichlet](const uint32_t nx, const uint32_t ny)
+	{
+		return nx >= 1 && ny >= 1 && nx + 1 < indep.w && ny + 1 < indep.h && !indep(nx, ny) && !dirichlet(nx, ny);
+	};
+	return excluded(x + 1, y) || excluded(x - 1, y) || excluded(x, y + 1) || excluded(x, y - 1);
+}
+
+/**
+ * @return true iff there is no Dirichlet condition at any of the sides (so that the operator without obstacles is singular)
+ */
+static bool isSingular(const BitGrid &dirichlet)
+{
+	return !dirichlet(0, 1) && !dirichlet(dirichlet.w - 1, 1) && !dirichlet(1, 0) && !dirichlet(1, dirichlet.h - 1);
+}
+
+PressureSolverSpectral::PressureSolverSpectral(const double dx, const double dy, const BitGrid &indep, const BitGrid &dirichlet)
+	: mx(indep.w - 2), my(indep.h - 2), rhsCoef(dx * dx * dy * dy),
+	xAnalysis(AxisBasis(mx, dirichlet(0, 1), dirichlet(indep.w - 1, 1)).analysis(mx)),
+	xSynthesis(AxisBasis(mx, dirichlet(0, 1), dirichlet(indep.w - 1, 1)).synthesis(mx)),
+	yAnalysis(AxisBasis(my, dirichlet(1, 0), dirichlet(1, indep.h - 1)).analysis(my)),
+	ySynthesis(AxisBasis(my, dirichlet(1, 0), dirichlet(1, indep.h - 1)).synthesis(my)),
+	eigenFactors(mx, my), work(mx, my), rhs(mx, my)
+{
+	const uint32_t wp = indep.w;
+	const uint32_t hp = indep.h;
+	const double wx = dy * dy;
+	const double wy = dx * dx;
+
+	const AxisBasis xBasis(mx, dirichlet(0, 1), dirichlet(wp - 1, 1));
+	const AxisBasis yBasis(my, dirichlet(1, 0), dirichlet(1, hp - 1));
+	vec<double> xNorms(mx), yNorms(my);
+	for (uint32_t k = 0; k < mx; k++)
+		xNorms[k] = xBasis.squaredNorm(mx, k);
+	for (uint32_t k = 0; k < my; k++)
+		yNorms[k] = yBasis.squaredNorm(my, k);
+	shifted = isSingular(dirichlet);
+	shift = 2 * (wx + wy);
+	for (uint32_t l = 0; l < my; l++)
+	{
+		for (uint32_t k = 0; k < mx; k++)
+		{
+			double eig = wx * xBasis.eigenvalue(k) + wy * yBasis.eigenvalue(l);
+			if (shifted && k == 0 && l == 0)
+				eig = shift;
+			eigenFactors(k, l) = 1 / (eig * xNorms[k] * yNorms[l]);
+		}
+	}
+
+	for (uint32_t y = 1; y < hp - 1; y++)
+	{
+		for (uint32_t x = 1; x < wp - 1; x++)
+		{
+			const uint32_t inner = (x - 1) + (y - 1) * mx;
+			if (dirichlet(x, y))
+			{
+				fixedCells.push_back(x + y * wp);
+				fixedInner.push_back(inner);
+				// without obstacles, a point is coupled to all its inner neighbors and to its neighbors at the Dirichlet sides
+				double diag = 0;
+				for (const Point nb : { Point(x + 1, y), Point(x - 1, y), Point(x, y + 1), Point(x, y - 1) })
+				{
+					const bool edge = nb.x == 0 || nb.y == 0 || uint32_t(nb.x) == wp - 1 || uint32_t(nb.y) == hp - 1;
+					if (!edge || dirichlet(nb))
+						diag += nb.y == int32_t(y) ? wx : wy;
+				}
+				fixedDiags.push_back(diag);
+			}
+			else if (indep(x, y))
+			{
+				unknownCells.push_back(x + y * wp);
+				unknownInner.push_back(inner);
+			}
+			if (!indep(x, y) || dirichlet(x, y))
+				continue;
+			// couplings to the Dirichlet points at the edges are the same with and without obstacles
+			auto addEdgeCoupling = [&](const uint32_t nx, const uint32_t ny, const double a)
+			{
+				if ((nx == 0 || ny == 0 || nx == wp - 1 || ny == hp - 1) && dirichlet(nx, ny))
+				{
+					dirichletInner.push_back(inner);
+					dirichletCells.push_back(nx + ny * wp);
+					dirichletCoefs.push_back(a);
+				}
+			};
+			addEdgeCoupling(x + 1, y, wx);
+			addEdgeCoupling(x - 1, y, wx);
+			addEdgeCoupling(x, y + 1, wy);
+			addEdgeCoupling(x, y - 1, wy);
+		}
+	}
+
+	// the differences between the rows of the actual operator and the operator without obstacles
+	for (uint32_t y = 1; y < hp - 1; y++)
+	{
+		for (uint32_t x = 1; x < wp - 1; x++)
+		{
+			if (!isRowChanged(x, y, indep, dirichlet))
+				continue;
+			const uint32_t inner = (x - 1) + (y - 1) * mx;
+			changedRows.push_back(inner);
+			changeStart.push_back(changeCols.size());
+			// the row of a Dirichlet point keeps only its diagonal (the same as without obstacles), so only the couplings are removed,
+			// the row of an unknown loses the couplings to the excluded neighbors
+			const bool fixed = dirichlet(x, y);
+			double diagChange = 0;
+			auto addChange = [&](const uint32_t nx, const uint32_t ny, const double a)
+			{
+				if (nx < 1 || ny < 1 || nx + 1 >= wp || ny + 1 >= hp)
+					return;
+				if (fixed || (!indep(nx, ny) && !dirichlet(nx, ny)))
+				{
+					changeCols.push_back((nx - 1) + (ny - 1) * mx);
+					changeVals.push_back(a);
+					if (!fixed)
+						diagChange -= a;
+				}
+			};
+			addChange(x + 1, y, wx);
+			addChange(x - 1, y, wx);
+			addChange(x, y + 1, wy);
+			addChange(x, y - 1, wy);
+			if (diagChange != 0)
+			{
+				changeCols.push_back(inner);
+				changeVals.push_back(diagChange);
+			}
+		}
+	}
+	changeStart.push_back(changeCols.size());
+	const uint32_t changed = changedRows.size();
+	capSize = changed + (shifted ? 1 : 0);
+	capWork.resize(capSize);
+
+	// capacitance matrix C = I + V^T A0^-1 U, where A = A0 + U V^T,
+	// U has the unit vectors of the changed rows (and the normalized constant vector if shifted) as columns,
+	// and V^T has the changes of the rows (and -shift times the normalized constant vector if shifted) as rows
+	capLU.assign(capSize * capSize, 0);
+	for (uint32_t j = 0; j < capSize; j++)
+	{
+		work.set_all(0);
+		if (j < changed)
+		{
+			work.data[changedRows[j]] = 1;
+			fastSolve(work);
+		}
+		else
+		{
+			work.set_all(1 / std::sqrt(double(mx) * my) / shift);
+		}
+		applyChange(work, capWork.data());
+		for (uint32_t i = 0; i < capSize; i++)
+			capLU[i * capSize + j] = capWork[i] + (i == j ? 1 : 0);
+	}
+
+	// LU factorization with partial pivoting
+	capPivots.resize(capSize);
+	for (uint32_t k = 0; k < capSize; k++)
+	{
+		uint32_t piv = k;
+		for (uint32_t i = k + 1; i < capSize; i++)
+		{
+			if (std::abs(capLU[i * capSize + k]) > std::abs(capLU[piv * capSize + k]))
+				piv = i;
+		}
+		capPivots[k] = piv;
+		if (piv != k)
+		{
+			for (uint32_t j = 0; j < capSize; j++)
+				std::swap(capLU[k * capSize + j], capLU[piv * capSize + j]);
+		}
+		for (uint32_t i = k + 1; i < capSize; i++)
+		{
+			const double f = capLU[i * capSize + k] / capLU[k * capSize + k];
+			capLU[i * capSize + k] = f;
+			for (uint32_t j = k + 1; j < capSize; j++)
+				capLU[i * capSize + j] -= f * capLU[k * capSize + j];
+		}
+	}
+}
+
+bool PressureSolverSpectral::isSuitable(const BitGrid &indep, const BitGrid &dirichlet)
+{
+	uint32_t size = isSingular(dirichlet) ? 1 : 0;
+	for (uint32_t y = 1; y < indep.h - 1; y++)
+	{
+		for (uint32_t x = 1; x < indep.w - 1; x++)
+		{
+			if (isRowChanged(x, y, indep, dirichlet))
+			{
+				size++;
+				if (size > MaxCapacitanceSize)
+					return false;
+			}
+		}
+	}
+	return true;
+}
+
+void PressureSolverSpectral::fastSolve(Grid<double> &q)
+{
+	for (uint32_t y = 0; y < my; y++)
+		xAnalysis.apply(q.data + y * mx, 1, q.data + y * mx, 1);
+	for (uint32_t x = 0; x < mx; x++)
+		yAnalysis.apply(q.data + x, mx, q.data + x, mx);
+	for (uint32_t i = 0; i < mx * my; i++)
+		q.data[i] *= eigenFactors.data[i];
+	for (uint32_t x = 0; x < mx; x++)
+		ySynthesis.apply(q.data + x, mx, q.data + x, mx);
+	for (uint32_t y = 0; y < my; y++)
+		xSynthesis.apply(q.data + y * mx, 1, q.data + y * mx, 1);
+}
+
+void PressureSolverSpectral::applyChange(const Grid<double> &q, double *const out) const
+{
+	for (uint32_t i = 0; i < changedRows.size(); i++)
+	{
+		double sm = 0;
+		for (uint32_t k = changeStart[i]; k < changeStart[i + 1]; k++)
+			sm += changeVals[k] * q.data[changeCols[k]];
+		out[i] = sm;
+	}
+	if (shifted)
+	{
+		double sm = 0;
+		for (uint32_t i = 0; i < mx * my; i++)
+			sm += q.data[i];
+		out[changedRows.size()] = -shift * sm / std::sqrt(double(mx) * my);
+	}
+}
+
+PressureSolveResult PressureSolverSpectral::solve(Grid<double> &p, const Grid<double> &field, const BoolFunc &)
+{
+	iterationCount++;
+	// the fictitious unknowns inside obstacles get zero RHS (their values don't influence the actual unknowns)
+	rhs.set_all(0);
+	for (uint32_t i = 0; i < unknownCells.size(); i++)
+		rhs.data[unknownInner[i]] = -rhsCoef * field.data[unknownCells[i]];
+	for (uint32_t i = 0; i < dirichletInner.size(); i++)
+		rhs.data[dirichletInner[i]] += dirichletCoefs[i] * p.data[dirichletCells[i]];
+	for (uint32_t i = 0; i < fixedCells.size(); i++)
+		rhs.data[fixedInner[i]] = fixedDiags[i] * p.data[fixedCells[i]];
+
+	work = rhs;
+	fastSolve(work);
+	if (capSize != 0)
+	{
+		// z = C^-1 V^T A0^-1 b, x = A0^-1 (b - U z)
+		applyChange(work, capWork.data());
+		for (uint32_t k = 0; k < capSize; k++)
+			std::swap(capWork[k], capWork[capPivots[k]]);
+		for (uint32_t k = 0; k < capSize; k++)
+		{
+			for (uint32_t i = k + 1; i < capSize; i++)
+				capWork[i] -= capLU[i * capSize + k] * capWork[k];
+		}
+		for (uint32_t k = capSize; k-- > 0; )
+		{
+			for (uint32_t j = k + 1; j < capSize; j++)
+				capWork[k] -= capLU[k * capSize + j] * capWork[j];
+			capWork[k] /= capLU[k * capSize + k];
+		}
+		work = rhs;
+		for (uint32_t i = 0; i < changedRows.size(); i++)
+			work.data[changedRows[i]] -= capWork[i];
+		if (shifted)
+		{
+			const double sub = capWork[changedRows.size()] / std::sqrt(double(mx) * my);
+			for (uint32_t i = 0; i < mx * my; i++)
+				work.data[i] -= sub;
+		}
+		fastSolve(work);
+	}
+
+	for (uint32_t i = 0; i < unknownCells.size(); i++)
+	{
+		if (std::isnan(work.data[unknownInner[i]]))
+			return PressureSolveResult::Diverged;
+		p.data[unknownCells[i]] = work.data[unknownInner[i]];
+	}
+	return PressureSolveResult::Converged;
+}
+
+uint64_t PressureSolverSpectral::getMemoryFootprint() const
+{
+	return xAnalysis.getMemoryFootprint() + xSynthesis.getMemoryFootprint()
+		+ yAnalysis.getMemoryFootprint() + ySynthesis.getMemoryFootprint()
+		+ 3 * uint64_t(mx) * my * sizeof(double)
+		+ (unknownCells.capacity() + unknownInner.capacity() + dirichletInner.capacity() + dirichletCells.capacity()) * sizeof(uint32_t)
+		+ dirichletCoefs.capacity() * sizeof(double)
+		+ (fixedCells.capacity() + fixedInner.capacity()) * sizeof(uint32_t)
+		+ (changedRows.capacity() + changeStart.capacity() + changeCols.capacity() + capPivots.capacity()) * sizeof(uint32_t)
+		+ (fixedDiags.capacity() + changeVals.capacity() + capLU.capacity() + capWork.capacity()) * sizeof(double);
+}
+
+}
@@ -0,0 +1,137 @@
+/**
+ * pressure-solver-spectral.hpp
+ *
+ * Author: Viktor Fukala
+ * Created on 2026/10/17
+ */
+#ifndef PRESSURE_SOLVER_SPECTRAL_HPP
+#define PRESSURE_SOLVER_SPECTRAL_HPP
+
+#include "pressure-solver.hpp"
+#include "trig-transform.hpp"
+#include "vec.hpp"
+
+namespace brandy0
+{
+
+/**
+ * Spectral (fast Poisson) solver of the Poisson equation for pressure.
+ *
+ * On the rectangle of all the inner points of the grid, the discretized operator without any obstacles is separable
+ * and is diagonalized by discrete sine / cosine transforms along the two axes
+ * (the type of each transform is given by the types of the boundary conditions at the two respective sides).
+ * The equation is then solved in O(N log N) time.
+ *
+ * Obstacles and points with pressure fixed inside the domain only change the rows of the operator at a few points near them.
+ * This low-rank change is handled by the capacitance matrix method: the capacitance matrix is computed and LU-factorized in the constructor
+ * and each solve then takes two fast solves and a (dense) solve with the capacitance matrix.
+ * The points inside obstacles are kept as fictitious unknowns with the original rows, so only the boundaries of the obstacles count.
+ * Hence, the method is only suitable for small sets of obstacles (@see isSuitable).
+ */
+class PressureSolverSpectral : public PressureSolver
+{
+private:
+	/// Maximum size of the capacitance matrix for the solver to be considered suitable
+	static constexpr uint32_t MaxCapacitanceSize = 128;
+
+	/// Number of inner points along the x axis
+	uint32_t mx;
+	/// Number of inner points along the y axis
+	uint32_t my;
+	/// Product dx^2 * dy^2 multiplying the RHS of the discretized equation
+	double rhsCoef;
+
+	/// Transform from values to the coefficients of the eigenvectors along the x axis
+	TrigTransform xAnalysis;
+	/// Transform from the coefficients of the eigenvectors to values along the x axis
+	TrigTransform xSynthesis;
+	/// Transform from values to the coefficients of the eigenvectors along the y axis
+	TrigTransform yAnalysis;
+	/// Transform from the coefficients of the eigenvectors to values along the y axis
+	TrigTransform ySynthesis;
+	/// For every pair of eigenvectors, the inverse of its eigenvalue divided by the squared norms of the two eigenvectors
+	Grid<double> eigenFactors;
+
+	/// Indices (into Grid::data) of the points corresponding to the unknowns
+	vec<uint32_t> unknownCells;
+	/// Indices (into work) of the points corresponding to the unknowns
+	vec<uint32_t> unknownInner;
+	/// Couplings of the unknowns with the Dirichlet points at the edges, which contribute to the RHS (same structure as in PressureSolverCholesky)
+	vec<uint32_t> dirichletInner;
+	/// @see dirichletInner
+	vec<uint32_t> dirichletCells;
+	/// @see dirichletInner
+	vec<double> dirichletCoefs;
+	/// Indices (into Grid::data) of the Dirichlet points inside the domain
+	vec<uint32_t> fixedCells;
+	/// Indices (into work) of the Dirichlet points inside the domain
+	vec<uint32_t> fixedInner;
+	/// Diagonal coefficients of the rows of the Dirichlet points inside the domain (the same as in the operator without obstacles)
+	vec<double> fixedDiags;
+
+	/**
+	 * True iff the operator without obstacles is singular (there are Neumann conditions at all sides).
+	 * Then, its zero eigenvalue is replaced by shift and the corresponding rank-one change is included in the capacitance matrix
+	 */
+	bool shifted;
+	/// @see shifted
+	double shift;
+	/// Points (indices into work) whose rows of the operator differ from the rows of the operator without obstacles
+	vec<uint32_t> changedRows;
+	/// Start of the difference of each changed row in changeCols and changeVals (of size changedRows.size() + 1)
+	vec<uint32_t> changeStart;
+	/// Columns (indices into work) of the nonzero differences of the changed rows
+	vec<uint32_t> changeCols;
+	/// Values of the nonzero differences of the changed rows
+	vec<double> changeVals;
+	/// Size of the capacitance matrix
+	uint32_t capSize;
+	/// LU factorization of the capacitance matrix (stored by rows, L with unit diagonal)
+	vec<double> capLU;
+	/// Row permutation of the LU factorization
+	vec<uint32_t> capPivots;
+	/// Work vector for the capacitance system
+	vec<double> capWork;
+
+	/// Work grid of the inner points
+	Grid<double> work;
+	/// Copy of the RHS of the current solve
+	Grid<double> rhs;
+
+	/**
+	 * Solves the equation with the operator without obstacles (with the zero eigenvalue shifted if shifted is true)
+	 * @param q the RHS on input, the solution on output
+	 */
+	void fastSolve(Grid<double> &q);
+	/**
+	 * Computes the product of the rows of the low-rank change of the operator with a vector
+	 * @param q vector to multiply
+	 * @param out array to write the capSize values of the product to
+	 */
+	void applyChange(const Grid<double> &q, double *out) const;
+
+public:
+	/**
+	 * Sets up the transforms and the capacitance matrix for a fixed geometry
+	 * @param dx spacial step along the x axis
+	 * @param dy spacial step along the y axis
+	 * @param indep grid of independent points (@see Simulator::indep)
+	 * @param dirichlet grid of points with pressure fixed by a Dirichlet condition (@see SimulatorClassic::dirichlet)
+	 */
+	PressureSolverSpectral(double dx, double dy, const BitGrid &indep, const BitGrid &dirichlet);
+
+	/**
+	 * Checks whether the geometry is close enough to a rectangle without obstacles for the solver to be efficient
+	 * @param indep grid of independent points (@see Simulator::indep)
+	 * @param dirichlet grid of points with pressure fixed by a Dirichlet condition (@see SimulatorClassic::dirichlet)
+	 * @return true iff the capacitance matrix would not be larger than MaxCapacitanceSize
+	 */
+	static bool isSuitable(const BitGrid &indep, const BitGrid &dirichlet);
+
+	PressureSolveResult solve(Grid<double> &p, const Grid<double> &field, const BoolFunc &pauseRequested) override;
+	uint64_t getMemoryFootprint() const override;
+};
+
+}
+
+#endif // PRESSURE_SOLVER_SPECTRAL_HPP
@@ -0,0 +1,158 @@
+/**
+ * pressure-solver.hpp
+ *
+ * Author: Viktor Fukala
+ * Created on 2026/10/17
+ */
+#ifndef PRESSURE_SOLVER_HPP
+#define PRESSURE_SOLVER_HPP
+
+#include <array>
+
+#include "bit-grid.hpp"
+#include "func.hpp"
+#include "grid.hpp"
+#include "str.hpp"
+
+namespace brandy0
+{
+
+/**
+ * Represents the method used to solve the Poisson equation for pressure in every step of the simulation
+ */
+enum PressureSolverType
+{
+	/// The spectral solver if suitable for the geometry (@see PressureSolverSpectral::isSuitable), otherwise the relaxation
+	Automatic,
+	Relaxation, Multigrid, Cholesky, Spectral, ConjugateGradient
+};
+
+/// Names of all the pressure solver types (as shown to the user) indexed by the PressureSolverType values
+const std::array<str, 6> PressureSolverNames{
+	"automatic", "relaxation", "multigrid", "direct (Cholesky)", "spectral (FFT)", "conjugate gradient"
+};
+
+/**
+ * Represents the preconditioner used by the conjugate gradient pressure solver
+ */
+enum PcgPreconditionerType
+{
+	/// Division by the diagonal
+	PcgJacobi,
+	/// Incomplete Cholesky factorization with zero fill-in
+	PcgIncompleteCholesky,
+	/// One multigrid V-cycle
+	PcgMultigrid
+};
+
+/// Names of all the preconditioners (as shown to the user) indexed by the PcgPreconditionerType values
+const std::array<str, 3> PcgPreconditionerNames{
+	"Jacobi", "incomplete Cholesky", "multigrid"
+};
+
+/**
+ * Represents the initial guess of the pressure field with which the Poisson equation for pressure is solved in each step
+ */
+enum PressureExtrapolation
+{
+	/// The pressure field of the previous step
+	PressureExtrapolationNone,
+	/// Linear extrapolation from the pressure fields of the last two steps
+	PressureExtrapolationLinear,
+	/// Quadratic extrapolation from the pressure fields of the last three steps
+	PressureExtrapolationQuadratic
+};
+
+/// Names of all the pressure extrapolations (as shown to the user) indexed by the PressureExtrapolation values
+const std::array<str, 3> PressureExtrapolationNames{
+	"none (previous step)", "linear", "quadratic"
+};
+
+/**
+ * Represents the rule by which the relaxation built into SimulatorClassic::iter decides that the Poisson equation for pressure is solved
+ */
+enum PressureStopCriterion
+{
+	/// The L1 norm of the change of the pressure in a sweep is below a limit proportional to the number of grid points
+	PressureStopChange,
+	/// The L2 norm of the residual relative to the L2 norm of the RHS is below the tolerance (checked once per a set number of sweeps)
+	PressureStopResidual
+};
+
+/// Names of all the stopping criteria (as shown to the user) indexed by the PressureStopCriterion values
+const std::array<str, 2> PressureStopCriterionNames{
+	"change per sweep", "relative residual"
+};
+
+/**
+ * Represents the floating-point precision of the sweeps of the relaxation built into SimulatorClassic::iter
+ */
+enum RelaxationPrecision
+{
+	/// The sweeps update the pressure in double precision
+	RelaxationPrecisionDouble,
+	/// The sweeps update a correction of the pressure in single precision, which is added to the pressure once per a set number of sweeps
+	/// (after which the residual, the RHS of the equation for the next correction, is recomputed in double precision)
+	RelaxationPrecisionMixed
+};
+
+/// Names of all the relaxation precisions (as shown to the user) indexed by the RelaxationPrecision values
+const std::array<str, 2> RelaxationPrecisionNames{
+	"double", "mixed (single-prec. sweeps)"
+};
+
+/**
+ * Represents the outcome of one call to PressureSolver::solve
+ */
+enum PressureSolveResult
+{
+	/// The solution has converged
+	Converged,
+	/// The solving has been interrupted by a pause request and can be resumed by calling solve again
+	Interrupted,
+	/// The cap on the number of iterations has been reached before convergence (the pressure field holds the approximation after the last iteration)
+	IterationCapReached,
+	/// The solution has diverged (some of the values are NaN)
+	Diverged
+};
+
+/**
+ * Abstract class for the solvers of the discretized Poisson equation for pressure.
+ *
+ * The unknowns are the values of pressure at the points that are independent (@see Simulator::indep) and not Dirichlet (@see SimulatorClassic::dirichlet).
+ * Each unknown is coupled to those of its four direct neighbors that are independent or Dirichlet,
+ * the remaining neighbors are excluded from the stencil (which corresponds to a Neumann condition at obstacle boundaries).
+ * The values at the Dirichlet points are fixed and should be set in the pressure field before solve is called.
+ */
+class PressureSolver
+{
+protected:
+	/// Total number of iterations performed by solve (@see getIterationCount)
+	uint64_t iterationCount = 0;
+
+public:
+	/**
+	 * Solves the Poisson equation for pressure
+	 * @param p pressure field; contains the initial guess when called, the solution (or its current approximation if not converged) afterwards
+	 * @param field RHS of the Poisson equation
+	 * @param pauseRequested function returning true iff the solving should be promptly interrupted
+	 * @return outcome of the solving
+	 */
+	virtual PressureSolveResult solve(Grid<double> &p, const Grid<double> &field, const BoolFunc &pauseRequested) = 0;
+	/**
+	 * @return number of bytes of memory allocated by the solver (for its precomputed data and work space)
+	 */
+	virtual uint64_t getMemoryFootprint() const = 0;
+	/**
+	 * @return total number of iterations performed by solve since the construction (the direct solvers count one per solved system)
+	 */
+	uint64_t getIterationCount() const
+	{
+		return iterationCount;
+	}
+	virtual ~PressureSolver() {}
+};
+
+}
+
+#endif // PRESSURE_SOLVER_HPP
@@ -10,11 +10,16 @@
 
 #include <gdkmm/general.h>
 
+#include <cairomm/pattern.h>
+#include <cairomm/surface.h>
+
+#include <cmath>
+
 namespace brandy0
 {
 
 ShapeConfigWidget::ShapeConfigWidget(ConfigStateAbstr *const parent, ShapeConfigWindowAbstr *const parentWindow)
-	: parent(parent), parentWindow(parentWindow), mouseInside(false)
+	: parent(parent), parentWindow(parentWindow), mouseInside(false), solid(0, 0), solidStale(true), tempSolid(0, 0), tempSolidMode(AddShapeModeDefault)
 {
 	set_has_window();
 	set_hexpand();
@@ -22,8 +27,8 @@ ShapeConfigWidget::ShapeConfigWidget(ConfigStateAbstr *const parent, ShapeConfig
 
 	parent->initListeners.plug([this](){ refresh(); activateRefresher(); });
 	parent->closeListeners.plug([this](){ deactivateRefresher(); });
-	parent->shapeStackChangeListeners.plug([this](){ refresh(); });
-	parent->dimensionsChangeListeners.plug([this](){ refresh(); });
+	parent->shapeStackChangeListeners.plug([this](){ solidStale = true; refresh(); });
+	parent->dimensionsChangeListeners.plug([this](){ solidStale = true; refresh(); });
 	parentWindow->nextShapeChangeListeners.plug([this](){ refresh(); });
 }
 
@@ -154,6 +159,84 @@ void ShapeConfigWidget::markPoint(const Cairo::RefPtr<Cairo::Context>& cr, const
 	markPoints(cr, baseCoors, vec<vec2d>{ p });
 }
 
+/**
+ * @param r red component (0 -- 1)
+ * @param g green component (0 -- 1)
+ * @param b blue component (0 -- 1)
+ * @return opaque pixel of the specified color in the Cairo ARGB32 format
+ */
+static uint32_t argbPixel(const double r, const double g, const double b)
+{
+	return 0xff000000u | uint32_t(std::lround(r * 255)) << 16 | uint32_t(std::lround(g * 255)) << 8 | uint32_t(std::lround(b * 255));
+}
+
+void ShapeConfigWidget::drawGrid(const Cairo::RefPtr<Cairo::Context>& cr, const vec<vec2d> &tempShape)
+{
+	const double w = parent->params->w, h = parent->params->h;
+	const uint32_t wp = parent->params->wp, hp = parent->params->hp;
+	if (solidStale || solid.w != wp || solid.h != hp)
+	{
+		solid = BitGrid(wp, hp);
+		parent->params->shapeStack.set(solid);
+		solidStale = false;
+	}
+	const uint32_t mode = parentWindow->addShapeMode;
+	if (tempSolid.w != wp || tempSolid.h != hp || tempShape != tempSolidShape || mode != tempSolidMode)
+	{
+		if (tempSolid.w != wp || tempSolid.h != hp)
+			tempSolid = BitGrid(wp, hp);
+		tempSolid.set_all(false);
+		if (mode == AddShapeRectangle && tempShape.size() == 2)
+			ObstacleRectangle(false, tempShape[0], tempShape[1]).fill(tempSolid);
+		else if (mode == AddShapePolygon && tempShape.size() >= 3)
+			ObstaclePolygon(false, tempShape).fill(tempSolid);
+		else if (mode == AddShapeCircle && tempShape.size() == 2)
+			ObstacleCircle(false, tempShape[0], tempShape[1], w, h).fill(tempSolid);
+		else if (mode == AddShapeEllipse && tempShape.size() == 2)
+			ObstacleEllipse(false, tempShape[0], tempShape[1]).fill(tempSolid);
+		tempSolidShape = tempShape;
+		tempSolidMode = mode;
+	}
+
+	double pw = 1, ph = 1;
+	cr->user_to_device_distance(pw, ph);
+	const uint32_t iw = std::max(1l, std::lround(std::ceil(std::abs(pw)))), ih = std::max(1l, std::lround(std::ceil(std::abs(ph))));
+	const Cairo::RefPtr<Cairo::ImageSurface> image = Cairo::ImageSurface::create(Cairo::FORMAT_ARGB32, iw, ih);
+	image->flush();
+	unsigned char *const data = image->get_data();
+	const int stride = image->get_stride();
+	// the solid points (and the points inside the shape being added) are colored in a checkerboard pattern, every other free point is light yellow;
+	// a point is drawn as the rectangle of the positions closer to it than to any other point (a point inside the shape being added as a rectangle of half the size)
+	const uint32_t solidEven = argbPixel(.75, .8, 1), solidOdd = argbPixel(.8, .75, 1), freeOdd = argbPixel(1, 1, 224 / 255.);
+	for (uint32_t j = 0; j < ih; j++)
+	{
+		uint32_t *const row = reinterpret_cast<uint32_t *>(data + uint64_t(j) * stride);
+		const double gy = (j + .5) / ih * (hp - 1);
+		const uint32_t y = std::min<uint32_t>(hp - 1, std::lround(gy));
+		const bool innerY = std::abs(gy - y) < .25;
+		for (uint32_t i = 0; i < iw; i++)
+		{
+			const double gx = (i + .5) / iw * (wp - 1);
+			const uint32_t x = std::min<uint32_t>(wp - 1, std::lround(gx));
+			const bool odd = (x & 1) != (y & 1);
+			if (solid(x, y) || (tempSolid(x, y) && innerY && std::abs(gx - x) < .25))
+				row[i] = odd ? solidOdd : solidEven;
+			else
+				row[i] = odd ? freeOdd : 0;
+		}
+	}
+	image->mark_dirty();
+
+	cr->save();
+	cr->scale(1. / iw, 1. / ih);
+	const Cairo::RefPtr<Cairo::SurfacePattern> pattern = Cairo::SurfacePattern::create(image);
+	pattern->set_filter(Cairo::FILTER_NEAREST);
+	cr->set_source(pattern);
+	cr->rectangle(0, 0, iw, ih);
+	cr->fill();
+	cr->restore();
+}
+
 bool ShapeConfigWidget::on_draw(const Cairo::RefPtr<Cairo::Context>& cr)
 {
 	// TODO: split into a few shorter methods
@@ -161,7 +244,6 @@ bool ShapeConfigWidget::on_draw(const Cairo::RefPtr<Cairo::Context>& cr)
 
 	const uint32_t sw = getWidth(), sh = getHeight();
 	const double w = parent->params->w, h = parent->params->h;
-	const uint32_t wp = parent->params->wp, hp = parent->params->hp;
 
 	cr->move_to(0, 0);
 	cr->line_to(sw, sh);
@@ -197,71 +279,11 @@ bool ShapeConfigWidget::on_draw(const Cairo::RefPtr<Cairo::Context>& cr)
 	cr->close_path();
 	cr->fill();
 
-	Grid<bool> solid(wp, hp);
-	parent->params->shapeStack.set(solid);
-
 	vec<vec2d> tempShape = parentWindow->nextShapeClicks;
 	if (mouseInside)
 		tempShape.push_back(mouseCoors);
-	Grid<bool> tempSolid(wp, hp);
-	tempSolid.set_all(false);
 	const uint32_t mode = parentWindow->addShapeMode;
-	if (mode == AddShapeRectangle && tempShape.size() == 2)
-		ObstacleRectangle(false, tempShape[0], tempShape[1]).fill(tempSolid);
-	else if (mode == AddShapePolygon && tempShape.size() >= 3)
-		ObstaclePolygon(false, tempShape).fill(tempSolid);
-	else if (mode == AddShapeCircle && tempShape.size() == 2)
-		ObstacleCircle(false, tempShape[0], tempShape[1], w, h).fill(tempSolid);
-	else if (mode == AddShapeEllipse && tempShape.size() == 2)
-		ObstacleEllipse(false, tempShape[0], tempShape[1]).fill(tempSolid);
-
-	const double dx = 1 / double(wp - 1) / 2;
-	const double dy = 1 / double(hp - 1) / 2;
-	for (uint32_t x = 0; x < wp; x++)
-	{
-		for (uint32_t y = 0; y < hp; y++)
-		{
-			const double xc = x / double(wp - 1);
-			const double yc = y / double(hp - 1);
-			if (solid(x, y) || (x & 1) != (y & 1))
-			{
-				if (solid(x, y))
-					if ((x & 1) == (y & 1))
-						cr->set_source_rgba(.75, .8, 1, 1);
-					else
-						cr->set_source_rgba(.8, .75, 1, 1);
-				else
-					Gdk::Cairo::set_source_rgba(cr, Gdk::RGBA("light yellow"));
-				const double x0 = x == 0 ? xc : xc - dx;
-				const double x1 = x == wp - 1 ? xc : xc + dx;
-				const double y0 = y == 0 ? yc : yc - dy;
-				const double y1 = y == hp - 1 ? yc : yc + dy;
-				cr->move_to(x0, y0);
-				cr->line_to(x0, y1);
-				cr->line_to(x1, y1);
-				cr->line_to(x1, y0);
-				cr->close_path();
-				cr->fill();
-			}
-			if (!solid(x, y) && tempSolid(x, y))
-			{
-				if ((x & 1) == (y & 1))
-					cr->set_source_rgba(.75, .8, 1, 1);
-				else
-					cr->set_source_rgba(.8, .75, 1, 1);
-				const double x0 = x == 0 ? xc : xc - dx / 2;
-				const double x1 = x == wp - 1 ? xc : xc + dx / 2;
-				const double y0 = y == 0 ? yc : yc - dy / 2;
-				const double y1 = y == hp - 1 ? yc : yc + dy / 2;
-				cr->move_to(x0, y0);
-				cr->line_to(x0, y1);
-				cr->line_to(x1, y1);
-				cr->line_to(x1, y0);
-				cr->close_path();
-				cr->fill();
-			}
-		}
-	}
+	drawGrid(cr, tempShape);
 
 	Gdk::Cairo::set_source_rgba(cr, Gdk::RGBA("black"));
 	for (const sptr<ObstacleShape>& shape : parent->params->shapeStack)
@@ -43,6 +43,17 @@ private:
 	/// True iff the mouse is currently inside (above) the container (inside the widget is necessary but not sufficient)
 	bool mouseInside;
 
+	/// Grid of the points made solid by the shown shapes (at the configured resolution)
+	BitGrid solid;
+	/// True iff solid has to be recomputed because the shapes or the dimensions have changed
+	bool solidStale;
+	/// Grid of the points inside the shape being added
+	BitGrid tempSolid;
+	/// Points of the shape being added for which tempSolid has been computed
+	vec<vec2d> tempSolidShape;
+	/// Add-shape mode for which tempSolid has been computed
+	uint32_t tempSolidMode;
+
 	void get_preferred_width_vfunc(int& minimum_width, int& natural_width) const override;
 	void get_preferred_height_vfunc(int& minimum_height, int& natural_height) const override;
 	void get_preferred_height_for_width_vfunc(int width, int& minimum_height, int& natural_height) const override;
@@ -64,6 +75,13 @@ private:
 	 * Equivalent to markPoints(cr, baseCoors, vec<vec2d>{ p }).
 	 */
 	void markPoint(const Cairo::RefPtr<Cairo::Context>& cr, const cairo_matrix_t& baseCoors, vec2d p) const;
+	/**
+	 * Draws the grid points (the solid ones and the ones inside the shape being added) as an image with one pixel per device pixel,
+	 * so that the cost of drawing doesn't depend on the resolution of the grid
+	 * @param cr context for drawing with coordinates in which (0, 0) -- (1, 1) is the container
+	 * @param tempShape points of the shape being added
+	 */
+	void drawGrid(const Cairo::RefPtr<Cairo::Context>& cr, const vec<vec2d> &tempShape);
 	bool on_draw(const Cairo::RefPtr<Cairo::Context>& cr) override;
 
 	/**
@@ -7,8 +7,10 @@
 #ifndef SIM_FRAME_HPP
 #define SIM_FRAME_HPP
 
+#include <type_traits>
+
 #include "grid.hpp"
-#include "vec2d.hpp"
+#include "vec2d-grid.hpp"
 
 namespace brandy0
 {
@@ -23,19 +25,29 @@ public:
 	/// Pressure field
 	Grid<double> p;
 	/// Velocity field
-	Grid<vec2d> u;
+	Vec2dGrid u;
+	/// Number of iterations of the solving of the Poisson equation for pressure in the step that computed this frame
+	uint64_t pressureIterations = 0;
+	/// Ratio of the L2 norms of the residual and of the RHS of the Poisson equation for pressure after it was solved in the step that computed this frame
+	double pressureResidual = 0;
+	/// Time step of the step that computed this frame
+	double dt = 0;
 
 	/**
 	 * Constructs a SimFrame object
 	 * @param p grid with the values of the pressure field
 	 * @param u grid with the values of the velocity field
 	 */
-	SimFrame(const Grid<double>& p, const Grid<vec2d>& u)
+	SimFrame(const Grid<double>& p, const Vec2dGrid& u)
 		: p(p), u(u)
 	{
 	}
 };
 
+// frames are moved (not copied) when swapped and when the vectors holding them are reallocated
+static_assert(std::is_nothrow_move_constructible<SimFrame>::value && std::is_nothrow_move_assignable<SimFrame>::value,
+	"SimFrame should be cheaply movable");
+
 }
 
 #endif // SIM_FRAME_HPP
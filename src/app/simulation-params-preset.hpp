@@ -60,6 +60,26 @@ public:
 	static constexpr uint32_t MinFrameCapacity = 16;
 	/// Maximum capacity for computed frames
 	static constexpr uint32_t MaxFrameCapacity = 16777216;
+	/// Default number of computation threads
+	static constexpr uint32_t DefaultThreadCount = 1;
+	/// Minimum number of computation threads
+	static constexpr uint32_t MinThreadCount = 1;
+	/// Maximum number of computation threads
+	static constexpr uint32_t MaxThreadCount = 256;
+	/// Default relative tolerance of the residual of the Poisson equation for pressure
+	static constexpr double DefaultPressureTolerance = 1e-6;
+	/// Minimum relative tolerance of the residual of the Poisson equation for pressure
+	static constexpr double MinPressureTolerance = 1e-15;
+	/// Maximum relative tolerance of the residual of the Poisson equation for pressure
+	static constexpr double MaxPressureTolerance = 1;
+	/// Default number of sweeps between two checks of the residual
+	static constexpr uint32_t DefaultResidualCheckPeriod = 10;
+	/// Maximum number of sweeps between two checks of the residual
+	static constexpr uint32_t MaxResidualCheckPeriod = 1000000;
+	/// Default cap on the number of iterations of the iterative pressure solvers in one step
+	static constexpr uint32_t DefaultPressureIterationCap = 10000000;
+	/// Maximum cap on the number of iterations of the iterative pressure solvers in one step
+	static constexpr uint32_t MaxPressureIterationCap = 1000000000;
 	/// Default density
 	static constexpr double DefaultRho = 1.0;
 	/// Minimum density
@@ -92,6 +112,14 @@ public:
 	static constexpr double MinDt = 1e-9;
 	/// Maximum dt (time step)
 	static constexpr double MaxDt = 1e1;
+	/// Default lower bound on the time step in the adaptive time stepping
+	static constexpr double DefaultMinDt = 1e-8;
+	/// Default upper bound on the Courant number in the adaptive time stepping
+	static constexpr double DefaultCourantNumber = .5;
+	/// Minimum upper bound on the Courant number in the adaptive time stepping
+	static constexpr double MinCourantNumber = 1e-3;
+	/// Maximum upper bound on the Courant number in the adaptive time stepping (the semi-Lagrangian advection is stable above 1, the upwind one clamps the bound to 1)
+	static constexpr double MaxCourantNumber = 100;
 	/// Default value of each component in a Dirichlet boundary condition for velocity
 	static constexpr double DefaultU = 0;
 	/// Maximum absolute value of each component in a Dirichlet boundary condition for velocity
@@ -10,10 +10,46 @@
 #include "boundary-cond.hpp"
 #include "grid.hpp"
 #include "obstacle-shape.hpp"
+#include "pressure-solver.hpp"
+#include "stencil-kernels.hpp"
 
 namespace brandy0
 {
 
+/**
+ * Represents the way the time step of the simulation is chosen
+ */
+enum TimeSteppingMode
+{
+	/// Every step is SimulationParams::dt long
+	TimeSteppingFixed,
+	/// Each step is as long as the Courant number and the viscous stability limit allow, within SimulationParams::minDt and SimulationParams::dt
+	TimeSteppingAdaptive
+};
+
+/// Names of all the time stepping modes (as shown to the user) indexed by the TimeSteppingMode values
+const std::array<str, 2> TimeSteppingModeNames{
+	"fixed", "adaptive (CFL)"
+};
+
+/**
+ * Represents the way the convective term of the momentum equation is discretized
+ */
+enum AdvectionScheme
+{
+	/// Explicit upwind differencing together with the explicit viscous term (stable only with a time step within the CFL and viscous limits)
+	AdvectionUpwind,
+	/// Semi-Lagrangian advection interpolating bilinearly at the back-traced points, followed by an implicit viscous step (stable with any time step)
+	AdvectionSemiLagrangianLinear,
+	/// Semi-Lagrangian advection interpolating bicubically (limited to the range of the bilinear stencil), followed by an implicit viscous step
+	AdvectionSemiLagrangianCubic
+};
+
+/// Names of all the advection schemes (as shown to the user) indexed by the AdvectionScheme values
+const std::array<str, 3> AdvectionSchemeNames{
+	"upwind (explicit)", "semi-Lagrangian, bilinear", "semi-Lagrangian, bicubic"
+};
+
 /**
  * Struct containing all parameters of a simulation
  */
@@ -27,7 +63,7 @@ struct SimulationParams
 	uint32_t wp;
 	/// Number of grid points along the y axis (height of the grid)
 	uint32_t hp;
-	/// Time step
+	/// Time step (the upper bound on the time step in the adaptive time stepping)
 	double dt;
 	/// Left boundary condition (at x = 0)
 	BoundaryCond bcx0;
@@ -50,10 +86,41 @@ struct SimulationParams
 	 * TODO: implement (setting in configuration and the expected behavior when >= 0 (computation pausing)
 	 */
 	double stopAfter;
-	/// Number of steps in each frame
+	/// Number of steps in each frame (in the adaptive time stepping, the frames are still dt * stepsPerFrame apart in the simulation time, @see getFrameTime)
 	uint32_t stepsPerFrame;
 	/// Capacity for computed frames (maximum number of computed frames stored at once)
 	uint32_t frameCapacity;
+	/// Method used to solve the Poisson equation for pressure
+	PressureSolverType pressureSolver = PressureSolverType::Automatic;
+	/// Preconditioner used when the Poisson equation for pressure is solved by the conjugate gradient method
+	PcgPreconditionerType pcgPreconditioner = PcgPreconditionerType::PcgIncompleteCholesky;
+	/// Initial guess of the pressure field for the solving of the Poisson equation for pressure in each step
+	PressureExtrapolation pressureExtrapolation = PressureExtrapolationNone;
+	/// Rule by which the relaxation built into SimulatorClassic::iter decides that the Poisson equation for pressure is solved
+	PressureStopCriterion pressureStopCriterion = PressureStopChange;
+	/// Upper bound on the ratio of the L2 norms of the residual and of the RHS of the Poisson equation for pressure for its solving to stop
+	/// (used by the residual stopping criterion and by the conjugate gradient solver)
+	double pressureTolerance = 1e-6;
+	/// Floating-point precision of the sweeps of the relaxation built into SimulatorClassic::iter
+	RelaxationPrecision relaxationPrecision = RelaxationPrecisionDouble;
+	/// Number of sweeps of the relaxation between two checks of the residual stopping criterion (and between two corrections of the pressure in the mixed precision)
+	uint32_t residualCheckPeriod = 10;
+	/// Cap on the number of iterations of the iterative pressure solvers (the sweeps of the relaxation, the V-cycles of the multigrid,
+	/// or the iterations of the conjugate gradient method) in one step (when reached, the step continues with the pressure after the last iteration)
+	uint32_t pressureIterationCap = 10000000;
+	/// Number of threads computing the simulation
+	uint32_t threadCount = 1;
+	/// Way the stencil passes of the simulation iterate over the points of the grid
+	CellIterationMode cellIteration = CellIterationAutomatic;
+	/// Way the time step is chosen
+	TimeSteppingMode timeStepping = TimeSteppingFixed;
+	/// Upper bound on the Courant number (the sum of |u_x| dt / dx, |u_y| dt / dy, and the viscous term) in the adaptive time stepping.
+	/// The semi-Lagrangian advection leaves out the viscous term (its viscous step is implicit) and is stable with numbers above 1 (the upwind one uses at most 1)
+	double courantNumber = .5;
+	/// Lower bound on the time step in the adaptive time stepping
+	double minDt = 1e-8;
+	/// Discretization of the convective term (and with it of the viscous term)
+	AdvectionScheme advection = AdvectionUpwind;
 
 	// TODO add compressibility indicator as member
 
@@ -66,6 +133,14 @@ struct SimulationParams
 	{
 	}
 
+	/**
+	 * @return simulation time between two consecutive base frames
+	 */
+	double getFrameTime() const
+	{
+		return dt * stepsPerFrame;
+	}
+
 	/**
 	 * @return spacial step of the discretization grid in the x direction
 	 */
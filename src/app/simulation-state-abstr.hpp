@@ -8,6 +8,7 @@
 #define SIMULATION_STATE_ABSTR_HPP
 
 #include "application-abstr.hpp"
+#include "domain-geometry.hpp"
 #include "listener-manager.hpp"
 #include "ptr.hpp"
 #include "sim-frame.hpp"
@@ -69,6 +70,8 @@ public:
 
 	/// Simulation parameters of the current simulation
 	uptr<SimulationParams> params;
+	/// Geometry of the simulated domain of the current simulation (shared by the simulator and the frame drawers)
+	sptr<const DomainGeometry> geometry;
 	/// Frame that should be currently drawn in the DisplayArea (that should be drawn when a redraw is issued)
 	uptr<SimFrame> curFrame;
 	
@@ -224,6 +227,25 @@ public:
 	 * @return number of computed iterations in the frame that is being computed now
 	 */
 	virtual uint32_t getComputedIter() = 0;
+	/**
+	 * A thread-safe method for retrieving the average number of iterations of the solving of the Poisson equation for pressure per step
+	 * @return average number of iterations per computed step (0 if no step has been computed yet)
+	 */
+	virtual double getAvgPressureIterations() = 0;
+	/**
+	 * A thread-safe method for retrieving the relative residual of the Poisson equation for pressure in the last computed step
+	 * @return ratio of the L2 norms of the residual and of the RHS (@see SimFrame::pressureResidual)
+	 */
+	virtual double getLastPressureResidual() = 0;
+	/**
+	 * A thread-safe method for retrieving the time step of the last computed step
+	 * @return time step of the last computed step (@see SimFrame::dt)
+	 */
+	virtual double getLastDt() = 0;
+	/**
+	 * @return number of bytes of memory allocated by the simulator's solver of the Poisson equation for pressure
+	 */
+	virtual uint64_t getSolverMemoryFootprint() = 0;
 
 	/**
 	 * Checks the validity of the specified video export time range
@@ -7,6 +7,7 @@
 #include "simulation-state.hpp"
 
 #include <chrono>
+#include <utility>
 
 #include <glibmm.h>
 
@@ -28,6 +29,9 @@ void SimulationState::start(const SimulationParams& params)
 	frameStepSize = 1;
 	time = 0;
 	computedIter = 0;
+	avgPressureIterations = 0;
+	lastPressureResidual = 0;
+	lastDt = params.dt;
 	editingTime = false;
 	playbackPaused = false;
 	playbackSpeedup = 1;
@@ -37,7 +41,8 @@ void SimulationState::start(const SimulationParams& params)
 	crashSignal = false;
 	frames.clear();
 	this->params = make_unique<SimulationParams>(params);
-	sim = make_unique<SimulatorClassic>(params);
+	geometry = DomainGeometry::create(params);
+	sim = make_unique<SimulatorClassic>(params, geometry);
 	sim->setPauseControl(&stopComputingSignal, &computingMutex);
 	frontDisplayMode = FrontDisplayModeDefault;
 	backDisplayMode = BackDisplayModeDefault;
@@ -151,6 +156,7 @@ void SimulationState::confirmVideoExport()
 {
 	videoExporter = make_unique<VideoExporter>(
 		*params,
+		geometry,
 		backDisplayMode,
 		frontDisplayMode,
 		videoExportFileLocation,
@@ -158,7 +164,7 @@ void SimulationState::confirmVideoExport()
 		videoExportStartTime,
 		videoExportEndTime,
 		MsPerBaseFrame / videoExportPlaybackSpeedup * frameStepSize,
-		params->dt * params->stepsPerFrame * frameStepSize,
+		params->getFrameTime() * frameStepSize,
 		videoExportWidth,
 		videoExportHeight,
 		videoExportBitrate,
@@ -208,6 +214,36 @@ uint32_t SimulationState::getComputedIter()
 	return ret;
 }
 
+double SimulationState::getAvgPressureIterations()
+{
+	framesMutex.lock();
+	const double ret = avgPressureIterations;
+	framesMutex.unlock();
+	return ret;
+}
+
+double SimulationState::getLastPressureResidual()
+{
+	framesMutex.lock();
+	const double ret = lastPressureResidual;
+	framesMutex.unlock();
+	return ret;
+}
+
+double SimulationState::getLastDt()
+{
+	framesMutex.lock();
+	const double ret = lastDt;
+	framesMutex.unlock();
+	return ret;
+}
+
+uint64_t SimulationState::getSolverMemoryFootprint()
+{
+	// the solver is created with the simulator and doesn't change during the computation, so no locking is needed
+	return sim->getSolverMemoryFootprint();
+}
+
 void SimulationState::showMainWindow()
 {
 	app->addWindow(mainWin);
@@ -224,12 +260,12 @@ void SimulationState::checkCapacity()
 {
 	if (frames.size() == params->frameCapacity)
 	{
-		vec<SimFrame> oldframes = frames;
+		vec<SimFrame> oldframes = std::move(frames);
 		frames.clear();
 		for (uint32_t i = 0; i < oldframes.size(); i++)
 		{
 			if (i % 2 == 0)
-				frames.push_back(oldframes[i]);
+				frames.push_back(std::move(oldframes[i]));
 		}
 		frameStepSize *= 2;
 	}
@@ -237,7 +273,7 @@ void SimulationState::checkCapacity()
 
 double SimulationState::getTime(const uint32_t frame)
 {
-	return params->dt * params->stepsPerFrame * frame;
+	return params->getFrameTime() * frame;
 }
 
 void SimulationState::addLastFrame()
@@ -247,6 +283,15 @@ void SimulationState::addLastFrame()
 		frames.push_back(sim->f1);
 	}
 	frameCount++;
+	updateStepStats();
+}
+
+void SimulationState::updateStepStats()
+{
+	avgPressureIterations = sim->computedSteps != 0 ? double(sim->pressureIterations) / sim->computedSteps : 0;
+	lastPressureResidual = sim->f1.pressureResidual;
+	if (sim->computedSteps != 0)
+		lastDt = sim->f1.dt;
 }
 
 void SimulationState::runComputeThread()
@@ -256,16 +301,20 @@ void SimulationState::runComputeThread()
 	framesMutex.lock();
 	uint32_t startiter = computedIter;
 	framesMutex.unlock();
+	const bool adaptive = params->timeStepping == TimeSteppingAdaptive;
 	while (true)
 	{
 		bool stop = false;
-		for (uint32_t i = startiter; i < params->stepsPerFrame; i++)
+		// in the adaptive time stepping, the steps of the frame continue until the simulation time of the frame (on which the last step lands)
+		const double frameEnd = getTime(frameCount);
+		for (uint32_t i = startiter; adaptive ? sim->time < frameEnd : i < params->stepsPerFrame; i++)
 		{
 			auto ctime = std::chrono::steady_clock::now();
 			if (ctime - lastupdate > updatefreq)
 			{
 				framesMutex.lock();
 				computedIter = i;
+				updateStepStats();
 				framesMutex.unlock();
 				computingMutex.lock();
 				if (stopComputingSignal)
@@ -278,6 +327,7 @@ void SimulationState::runComputeThread()
 				computingMutex.unlock();
 				lastupdate = ctime;
 			}
+			sim->stepUntil = frameEnd;
 			sim->iter();
 			if (sim->crashed)
 			{
@@ -339,7 +389,7 @@ void SimulationState::startComputeThread()
 
 void SimulationState::updateComputedTime()
 {
-	computedTime = (frames.size() - 1) * frameStepSize * params->stepsPerFrame * params->dt;
+	computedTime = (frames.size() - 1) * frameStepSize * params->getFrameTime();
 }
 
 bool SimulationState::update()
@@ -365,7 +415,7 @@ bool SimulationState::update()
 		{
 			if (playbackMode == PlaybackMode::PlayUntilEnd || playbackMode == PlaybackMode::Loop)
 			{
-				time += params->stepsPerFrame * params->dt * playbackSpeedup * elapsedms / MsPerBaseFrame;
+				time += params->getFrameTime() * playbackSpeedup * elapsedms / MsPerBaseFrame;
 				if (time > computedTime)
 				{
 					if (playbackMode == PlaybackMode::PlayUntilEnd)
@@ -394,7 +444,7 @@ bool SimulationState::update()
 	{
 		if (!videoExportPlaybackPaused && !videoExportEditingTime)
 		{
-			videoExportTime += params->stepsPerFrame * params->dt * videoExportPlaybackSpeedup * elapsedms / MsPerBaseFrame;
+			videoExportTime += params->getFrameTime() * videoExportPlaybackSpeedup * elapsedms / MsPerBaseFrame;
 			if (videoExportTime > videoExportEndTime)
 				videoExportTime = videoExportEndTime;
 		}
@@ -407,7 +457,7 @@ bool SimulationState::update()
 
 uint32_t SimulationState::getFrameNumber(const double t)
 {
-	uint32_t frame = round(t / (params->stepsPerFrame * params->dt) / frameStepSize);
+	uint32_t frame = round(t / params->getFrameTime() / frameStepSize);
 	if (frame >= frames.size())
 		frame = frames.size() - 1;
 	return frame;
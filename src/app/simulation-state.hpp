@@ -71,6 +71,12 @@ private:
 	uint32_t frameStepSize;
 	/// Number of computed iterations in the current frame last time this variable was update
 	uint32_t computedIter;
+	/// Average number of iterations of the pressure solving per step last time this variable was updated (together with computedIter)
+	double avgPressureIterations;
+	/// Relative residual of the pressure in the last computed step when avgPressureIterations was last updated
+	double lastPressureResidual;
+	/// Time step of the last computed step when avgPressureIterations was last updated
+	double lastDt;
 	/// Timer which periodically recalculates current values (e.g. advances time) and requests redraws of the display area
 	sigc::connection updateConnection;
 
@@ -97,6 +103,11 @@ private:
 	 * Increments frameCount and if the current frame should be stored, reads it from the simulator and stores it in the frames vector
 	 */
 	void addLastFrame();
+	/**
+	 * Reads the statistics of the steps from the simulator into avgPressureIterations, lastPressureResidual, and lastDt
+	 * (framesMutex must be held by the caller if the computation is running)
+	 */
+	void updateStepStats();
 	/**
 	 * @param number zero-indexed number of a base frame
 	 * @return simulation time of the specified base frame
@@ -169,6 +180,10 @@ public:
 	bool isComputing() override;
 	uint32_t getFramesStored() override;
 	uint32_t getComputedIter() override;
+	double getAvgPressureIterations() override;
+	double getLastPressureResidual() override;
+	double getLastDt() override;
+	uint64_t getSolverMemoryFootprint() override;
 
 	void videoExportValidateRange() override;
 	void videoExportClampTime() override;
@@ -6,6 +6,8 @@
  */
 #include "simulation-window.hpp"
 
+#include <cmath>
+
 #include "conv-utils.hpp"
 #include "display-modes.hpp"
 
@@ -119,6 +121,9 @@ SimulationWindow::SimulationWindow(SimulationStateAbstr *const parent)
 	computingGrid.attach(computingStatusLabel, 0, 1);
 	computingGrid.attach(frameBufferLabel, 0, 2);
 	computingGrid.attach(curIterLabel, 0, 3);
+	computingGrid.attach(solverMemoryLabel, 0, 4);
+	computingGrid.attach(solverIterLabel, 0, 5);
+	computingGrid.attach(solverResidualLabel, 0, 6);
 	StyleManager::setPadding(computingGrid);
 	computingFrame.add(computingGrid);
 
@@ -242,7 +247,14 @@ void SimulationWindow::updateStats()
 	const uint32_t fcap = parent->params->frameCapacity;
 	frameBufferLabel.set_text("frames in buffer: " + ConvUtils::intToZeropadStringByOrder(parent->getFramesStored(), fcap) + " / " + std::to_string(fcap));
 	const uint32_t sperframe = parent->params->stepsPerFrame;
-	curIterLabel.set_text("iter. of frame: " + ConvUtils::intToZeropadStringByOrder(parent->getComputedIter(), sperframe) + " / " + std::to_string(sperframe));
+	// in the adaptive time stepping, the number of steps in a frame isn't known in advance
+	if (parent->params->timeStepping == TimeSteppingAdaptive)
+		curIterLabel.set_text("iter. of frame: " + std::to_string(parent->getComputedIter()) + " (dt = " + ConvUtils::defaultToString(parent->getLastDt()) + ")");
+	else
+		curIterLabel.set_text("iter. of frame: " + ConvUtils::intToZeropadStringByOrder(parent->getComputedIter(), sperframe) + " / " + std::to_string(sperframe));
+	solverMemoryLabel.set_text("solver memory: " + ConvUtils::bytesToString(parent->getSolverMemoryFootprint()));
+	solverIterLabel.set_text("solver iter. per step: " + ConvUtils::defaultToString(std::round(parent->getAvgPressureIterations() * 10) / 10));
+	solverResidualLabel.set_text("rel. residual: " + ConvUtils::defaultToString(parent->getLastPressureResidual()));
 	timeLabel.set_text("t = " + ConvUtils::timeToString(parent->time, parent->computedTime) + " (of " + ConvUtils::timeToString(parent->computedTime) + ")");
 	playbackSpeedLabel.set_text("playback speed " + ConvUtils::speedupToString(parent->playbackSpeedup) + "x");
 }
@@ -60,6 +60,12 @@ private:
 	Gtk::Label frameBufferLabel;
 	/// Label with the number of iterations computed as part of the current frame (and their total number required for one frame)
 	Gtk::Label curIterLabel;
+	/// Label with the memory footprint of the solver of the Poisson equation for pressure
+	Gtk::Label solverMemoryLabel;
+	/// Label with the average number of iterations of the solving of the Poisson equation for pressure per step
+	Gtk::Label solverIterLabel;
+	/// Label with the relative residual of the Poisson equation for pressure in the last computed step
+	Gtk::Label solverResidualLabel;
 	/// Label indicating the status of the simulation computation (running / paused / diverged)
 	Gtk::Label computingStatusLabel;
 
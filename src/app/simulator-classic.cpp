@@ -6,140 +6,188 @@
  */
 #include "simulator-classic.hpp"
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <type_traits>
+#include <utility>
+
+#include "pressure-solver-cholesky.hpp"
+#include "pressure-solver-conjugate-gradient.hpp"
+#include "pressure-solver-multigrid.hpp"
+#include "pressure-solver-spectral.hpp"
+#include "stencil-kernels.hpp"
+
 namespace brandy0
 {
 
-void SimulatorClassic::visit(const Point p)
+SimulatorClassic::SimulatorClassic(const SimulationParams& params, sptr<const DomainGeometry> geometry)
+	: Simulator(params, std::move(geometry)), ww(wp, hp), field(wp, hp), dirichlet(this->geometry->dirichlet), relaxMask(wp, hp), relaxInvDiag(wp, hp), lapL1limit(.001 * wp * hp / 64 / 64), relResidualLimit(params.pressureTolerance),
+	stopCriterion(params.pressureStopCriterion), residualCheckPeriod(std::max(params.residualCheckPeriod, 1u)), iterationCap(params.pressureIterationCap), crashLimit(1e13),
+	pressureExtrapolation(params.pressureExtrapolation),
+	olderP(pressureExtrapolation == PressureExtrapolationQuadratic ? wp : 0, pressureExtrapolation == PressureExtrapolationQuadratic ? hp : 0),
+	pressureHistory(1), lastDt(dt), prevDt(dt), stepIterations(0),
+	relaxationPrecision(params.relaxationPrecision),
+	correction(relaxationPrecision == RelaxationPrecisionMixed ? wp : 0, relaxationPrecision == RelaxationPrecisionMixed ? hp : 0),
+	correctionRhs(correction.w, correction.h), relaxInvDiagSingle(correction.w, correction.h),
+	pool(std::max(params.threadCount, 1u)),
+	bandCount(std::max(1u, std::min({pool.getThreadCount(), wp * hp / MinBandPoints, hp - 2}))),
+	rowDl1(hp), bandCrashed(bandCount), rowResidualSq(hp), rowFieldSq(hp), rowMaxRate(hp), stepEndTime(0),
+	advection(params.advection),
+	advected(advection != AdvectionUpwind && nu > 0 ? wp : 0, advection != AdvectionUpwind && nu > 0 ? hp : 0), rowAdvectedL1(hp),
+	blockSweeps(uint64_t(wp) * hp >= MinTemporalBlockingPoints && (hp - 2) / bandCount >= 4 * TemporalBlockSweeps ? TemporalBlockSweeps : 1)
 {
-	if (visited(p))
-		return;
-	visited(p) = true;
-	if (p.x != 0 && indep(p.x - 1, p.y))
-		visit(Point(p.x - 1, p.y));
-	if (uint32_t(p.x + 1) != wp && indep(p.x + 1, p.y))
-		visit(Point(p.x + 1, p.y));
-	if (p.y != 0 && indep(p.x, p.y - 1))
-		visit(Point(p.x, p.y - 1));
-	if (uint32_t(p.y + 1) != hp && indep(p.x, p.y + 1))
-		visit(Point(p.x, p.y + 1));
+	// the stencil kernels read (and discard) the values at the non-independent points, so keep them initialized
+	ww.set_all(vec2d(0, 0));
+	field.set_all(0);
+	buildRelaxationStencil();
+	correction.set_all(0);
+	correctionRhs.set_all(0);
+	if (relaxationPrecision == RelaxationPrecisionMixed)
+		for (uint32_t i = 0; i < wp * hp; i++)
+			relaxInvDiagSingle.data[i] = float(relaxInvDiag.data[i]);
+	selectBoundarySpecializations();
+
+	const vec<GridRun> &runs = this->geometry->indepRuns;
+	spanIteration = params.cellIteration == CellIterationSpans
+		|| (params.cellIteration == CellIterationAutomatic && !runs.empty() && double(indep.count()) / runs.size() >= MinAverageRunLength);
+
+	PressureSolverType solverType = params.pressureSolver;
+	if (solverType == PressureSolverType::Automatic)
+		solverType = PressureSolverSpectral::isSuitable(indep, dirichlet) ? PressureSolverType::Spectral : PressureSolverType::Relaxation;
+	if (solverType == PressureSolverType::Multigrid)
+		pressureSolver = make_unique<PressureSolverMultigrid>(dx, dy, indep, dirichlet, lapL1limit, std::max(iterationCap, 1u));
+	else if (solverType == PressureSolverType::Cholesky)
+		pressureSolver = make_unique<PressureSolverCholesky>(dx, dy, indep, dirichlet);
+	else if (solverType == PressureSolverType::Spectral)
+		pressureSolver = make_unique<PressureSolverSpectral>(dx, dy, indep, dirichlet);
+	else if (solverType == PressureSolverType::ConjugateGradient)
+		pressureSolver = make_unique<PressureSolverConjugateGradient>(dx, dy, indep, dirichlet, relResidualLimit, params.pcgPreconditioner, std::max(iterationCap, 1u));
 }
 
 SimulatorClassic::SimulatorClassic(const SimulationParams& params)
-	: Simulator(params), ww(wp, hp), field(wp, hp), dirichlet(wp, hp), visited(wp, hp), lapL1limit(.001 * wp * hp / 64 / 64), crashLimit(1e13)
+	: SimulatorClassic(params, DomainGeometry::create(params))
 {
-	dirichlet.set_all(false);
-	if (bcx0.ptype == BoundaryCondType::Dirichlet)
-		for (uint32_t y = 0; y < hp; y++)
-			dirichlet(0, y) = true;
-	if (bcx1.ptype == BoundaryCondType::Dirichlet)
-		for (uint32_t y = 0; y < hp; y++)
-			dirichlet(wp - 1, y) = true;
-	if (bcy0.ptype == BoundaryCondType::Dirichlet)
-		for (uint32_t x = 0; x < wp; x++)
-			dirichlet(x, 0) = true;
-	if (bcy1.ptype == BoundaryCondType::Dirichlet)
-		for (uint32_t x = 0; x < wp; x++)
-			dirichlet(x, hp - 1) = true;
-	
-	// search the grid as a graph and for each connected component without any points with
-	// pressure set by a Dirichlet b.c., choose one that will be set that way
-	visited.set_all(false);
-	for (uint32_t y = 0; y < hp; y++)
+}
+
+void SimulatorClassic::buildRelaxationStencil()
+{
+	relaxMask.set_all(0);
+	relaxInvDiag.set_all(0);
+	// a neighbor takes part in the stencil iff its pressure is either an unknown or set by a Dirichlet b.c.
+	auto inStencil = [this](const uint32_t x, const uint32_t y) { return indep(x, y) || dirichlet(x, y); };
+	for (uint32_t y = 1; y < hp - 1; y++)
 	{
-		for (uint32_t x = 0; x < wp; x++)
+		for (uint32_t x = 1; x < wp - 1; x++)
 		{
-			if (dirichlet(x, y))
-				visit(Point(x, y));
-			else if (!indep(x, y))
-				visited(x, y) = true;
+			if (!indep(x, y) || dirichlet(x, y))
+				continue;
+			uint8_t m = RelaxUnknown;
+			double coef = 2 * dx * dx + 2 * dy * dy;
+			if (inStencil(x + 1, y))
+				m |= RelaxRight;
+			else
+				coef -= dy * dy;
+			if (inStencil(x - 1, y))
+				m |= RelaxLeft;
+			else
+				coef -= dy * dy;
+			if (inStencil(x, y + 1))
+				m |= RelaxUp;
+			else
+				coef -= dx * dx;
+			if (inStencil(x, y - 1))
+				m |= RelaxDown;
+			else
+				coef -= dx * dx;
+			relaxMask(x, y) = m;
+			relaxInvDiag(x, y) = 1 / coef;
 		}
 	}
-	for (uint32_t y = 0; y < hp; y++)
+	// split the unknowns of each row into maximal runs of interior and of non-interior ones
+	relaxRuns.clear();
+	relaxRowRuns.assign(2, 0);
+	for (uint32_t y = 1; y < hp - 1; y++)
 	{
-		for (uint32_t x = 0; x < wp; x++)
+		uint32_t x = 1;
+		while (x < wp - 1)
 		{
-			if (!visited(x, y))
+			if (!(relaxMask(x, y) & RelaxUnknown))
 			{
-				dirichlet(x, y) = true;
-				visit(Point(x, y));
+				x++;
+				continue;
 			}
+			const bool interior = relaxMask(x, y) == RelaxInterior;
+			const uint32_t x0 = x;
+			while (x < wp - 1 && (relaxMask(x, y) & RelaxUnknown) && (relaxMask(x, y) == RelaxInterior) == interior)
+				x++;
+			relaxRuns.push_back({{y, x0, x}, interior});
 		}
+		relaxRowRuns.push_back(relaxRuns.size());
 	}
+	relaxRowRuns.push_back(relaxRuns.size());
 }
 
-void SimulatorClassic::enforcePBoundary(Grid<double>& p)
+void SimulatorClassic::forEachBand(const std::function<void(uint32_t, uint32_t, uint32_t)> &fn)
 {
-	if (bcx0.ptype == BoundaryCondType::Dirichlet)
-	{
-		for (uint32_t y = 0; y < hp; y++)
-			p(0, y) = bcx0.p;
-	}
-	else
-	{
-		for (uint32_t y = 0; y < hp; y++)
-			p(0, y) = p(1, y);
-	}
-	if (bcx1.ptype == BoundaryCondType::Dirichlet)
+	pool.run(bandCount, [this, &fn](const uint32_t b)
 	{
-		for (uint32_t y = 0; y < hp; y++)
-			p(wp - 1, y) = bcx1.p;
-	}
-	else
-	{
-		for (uint32_t y = 0; y < hp; y++)
-			p(wp - 1, y) = p(wp - 2, y);
-	}
-	if (bcy0.ptype == BoundaryCondType::Dirichlet)
-	{
-		for (uint32_t x = 0; x < wp; x++)
-			p(x, 0) = bcy0.p;
-	}
-	else
+		fn(b, 1 + (hp - 2) * b / bandCount, 1 + (hp - 2) * (b + 1) / bandCount);
+	});
+}
+
+bool SimulatorClassic::collectBandCrashes()
+{
+	bool ret = false;
+	for (uint8_t &c : bandCrashed)
 	{
-		for (uint32_t x = 0; x < wp; x++)
-			p(x, 0) = p(x, 1);
+		ret = ret || c;
+		c = false;
 	}
-	if (bcy1.ptype == BoundaryCondType::Dirichlet)
+	return ret;
+}
+
+template <BoundaryCondType X0, BoundaryCondType X1, BoundaryCondType Y0, BoundaryCondType Y1, bool Obstacles>
+void SimulatorClassic::enforcePBoundaryFor(Grid<double>& p)
+{
+	// the types are template parameters, so the selects below are resolved at compile time
+	for (uint32_t y = 0; y < hp; y++)
 	{
-		for (uint32_t x = 0; x < wp; x++)
-			p(x, hp - 1) = bcy1.p;
+		p(0, y) = X0 == BoundaryCondType::Dirichlet ? bcx0.p : p(1, y);
+		p(wp - 1, y) = X1 == BoundaryCondType::Dirichlet ? bcx1.p : p(wp - 2, y);
 	}
-	else
+	for (uint32_t x = 0; x < wp; x++)
 	{
-		for (uint32_t x = 0; x < wp; x++)
-			p(x, hp - 1) = p(x, hp - 2);
+		p(x, 0) = Y0 == BoundaryCondType::Dirichlet ? bcy0.p : p(x, 1);
+		p(x, hp - 1) = Y1 == BoundaryCondType::Dirichlet ? bcy1.p : p(x, hp - 2);
 	}
-	for (uint32_t y = 1; y < hp - 1; y++)
+	// the pinned points are independent, so they may be read by the averaging below (which only writes non-independent points)
+	for (const Point &pt : geometry->pinnedPoints)
+		p(pt) = 0;
+	if constexpr (Obstacles)
 	{
-		for (uint32_t x = 1; x < wp - 1; x++)
+		for (const ObstacleBoundaryPoint &bp : geometry->obstacleBoundary)
 		{
-			if (dirichlet(x, y))
-			{
-				p(x, y) = 0;
-				continue;
-			}
-			if (solid(x, y) || indep(x, y))
-				continue;
-			
 			// average the pressure from neighbors
+			const uint32_t x = bp.pos.x, y = bp.pos.y;
 			uint32_t cou = 0;
 			double sm = 0;
-			if (indep(x - 1, y))
+			if (bp.indepNeighbors & 1)
 			{
 				sm += p(x - 1, y);
 				cou++;
 			}
-			if (indep(x + 1, y))
+			if (bp.indepNeighbors & 2)
 			{
 				sm += p(x + 1, y);
 				cou++;
 			}
-			if (indep(x, y - 1))
+			if (bp.indepNeighbors & 4)
 			{
 				sm += p(x, y - 1);
 				cou++;
 			}
-			if (indep(x, y + 1))
+			if (bp.indepNeighbors & 8)
 			{
 				sm += p(x, y + 1);
 				cou++;
@@ -149,190 +197,607 @@ void SimulatorClassic::enforcePBoundary(Grid<double>& p)
 	}
 }
 
-void SimulatorClassic::enforceUBoundary(Grid<vec2d>& u)
+template <BoundaryCondType X0, BoundaryCondType X1, BoundaryCondType Y0, BoundaryCondType Y1, bool Obstacles>
+void SimulatorClassic::enforceUBoundaryFor(Vec2dGrid& u)
 {
-	if (bcx0.utype == BoundaryCondType::Dirichlet)
+	// the rows y = 0 and y = h are copied from the inner rows with their edges already set under a Neumann b.c.
+	enforceUBoundaryRowsFor<X0, X1, Y0, Y1>(u, 1, hp - 1);
+	enforceUBoundaryRowsFor<X0, X1, Y0, Y1>(u, 0, 1);
+	enforceUBoundaryRowsFor<X0, X1, Y0, Y1>(u, hp - 1, hp);
+
+	// at obstacle boundaries, the velocity is given as (0, 0) by the no-slip condition
+	if constexpr (Obstacles)
 	{
-		for (uint32_t y = 0; y < hp; y++)
-			u(0, y) = bcx0.u;
+		for (const ObstacleBoundaryPoint &bp : geometry->obstacleBoundary)
+			u(bp.pos) = vec2d(0, 0);
 	}
-	else
+}
+
+template <BoundaryCondType X0, BoundaryCondType X1, BoundaryCondType Y0, BoundaryCondType Y1>
+void SimulatorClassic::enforceUBoundaryRowsFor(Vec2dGrid& u, const uint32_t y0, const uint32_t y1)
+{
+	for (uint32_t y = y0; y < y1; y++)
 	{
-		for (uint32_t y = 0; y < hp; y++)
-			u(0, y) = u(1, y);
+		if (y == 0 || y == hp - 1)
+		{
+			const bool dirichlet = (y == 0 ? Y0 : Y1) == BoundaryCondType::Dirichlet;
+			const vec2d bcu = y == 0 ? bcy0.u : bcy1.u;
+			const uint32_t src = y == 0 ? 1 : hp - 2;
+			for (uint32_t x = 0; x < wp; x++)
+				u(x, y) = dirichlet ? bcu : vec2d(u(x, src));
+		}
+		else
+		{
+			u(0, y) = X0 == BoundaryCondType::Dirichlet ? bcx0.u : vec2d(u(1, y));
+			u(wp - 1, y) = X1 == BoundaryCondType::Dirichlet ? bcx1.u : vec2d(u(wp - 2, y));
+		}
 	}
-	if (bcx1.utype == BoundaryCondType::Dirichlet)
+}
+
+/**
+ * Table of the specializations of the boundary condition enforcement indexed by SimulatorClassic::boundarySpecializationIndex
+ * @tparam Fn type of the pointers to the specializations
+ * @tparam Specialization template producing the pointer to the specialization for given template arguments
+ */
+template <typename Fn, template <BoundaryCondType, BoundaryCondType, BoundaryCondType, BoundaryCondType, bool> class Specialization, size_t... I>
+static constexpr std::array<Fn, sizeof...(I)> boundarySpecializations(std::index_sequence<I...>)
+{
+	return {Specialization<BoundaryCondType(I >> 4 & 1), BoundaryCondType(I >> 3 & 1), BoundaryCondType(I >> 2 & 1), BoundaryCondType(I >> 1 & 1), bool(I & 1)>::fn...};
+}
+
+template <BoundaryCondType X0, BoundaryCondType X1, BoundaryCondType Y0, BoundaryCondType Y1, bool Obstacles>
+struct SimulatorClassic::PBoundarySpecialization
+{
+	static constexpr PBoundaryFn fn = &SimulatorClassic::enforcePBoundaryFor<X0, X1, Y0, Y1, Obstacles>;
+};
+
+template <BoundaryCondType X0, BoundaryCondType X1, BoundaryCondType Y0, BoundaryCondType Y1, bool Obstacles>
+struct SimulatorClassic::UBoundarySpecialization
+{
+	static constexpr UBoundaryFn fn = &SimulatorClassic::enforceUBoundaryFor<X0, X1, Y0, Y1, Obstacles>;
+};
+
+template <BoundaryCondType X0, BoundaryCondType X1, BoundaryCondType Y0, BoundaryCondType Y1, bool Obstacles>
+struct SimulatorClassic::UBoundaryRowsSpecialization
+{
+	static constexpr UBoundaryRowsFn fn = &SimulatorClassic::enforceUBoundaryRowsFor<X0, X1, Y0, Y1>;
+};
+
+void SimulatorClassic::selectBoundarySpecializations()
+{
+	static constexpr auto pFns = boundarySpecializations<PBoundaryFn, PBoundarySpecialization>(std::make_index_sequence<32>());
+	static constexpr auto uFns = boundarySpecializations<UBoundaryFn, UBoundarySpecialization>(std::make_index_sequence<32>());
+	static constexpr auto uRowsFns = boundarySpecializations<UBoundaryRowsFn, UBoundaryRowsSpecialization>(std::make_index_sequence<32>());
+	const bool obstacles = !geometry->obstacleBoundary.empty();
+	const uint32_t pIndex = bcx0.ptype << 4 | bcx1.ptype << 3 | bcy0.ptype << 2 | bcy1.ptype << 1 | obstacles;
+	const uint32_t uIndex = bcx0.utype << 4 | bcx1.utype << 3 | bcy0.utype << 2 | bcy1.utype << 1 | obstacles;
+	enforcePBoundaryFn = pFns[pIndex];
+	enforceUBoundaryFn = uFns[uIndex];
+	enforceUBoundaryRowsFn = uRowsFns[uIndex];
+}
+
+template <typename T>
+double SimulatorClassic::relaxHalfSweepRow(Grid<T> &p, const Grid<T> &rhs, const Grid<T> &invDiag, const uint32_t y, const uint32_t color, double dl1)
+{
+	// the first point of the row with the color of the half-sweep
+	const uint32_t x0 = 2 - (y + color) % 2;
+	if (!spanIteration)
+		return StencilKernels::relaxRow(p, rhs, relaxMask, invDiag, y, x0, dx, dy, dl1);
+	// the interior runs don't need the masks, the general kernel only handles the runs at the boundaries
+	for (uint32_t r = relaxRowRuns[y]; r < relaxRowRuns[y + 1]; r++)
 	{
-		for (uint32_t y = 0; y < hp; y++)
-			u(wp - 1, y) = bcx1.u;
+		const RelaxationRun &rr = relaxRuns[r];
+		dl1 = rr.interior ? StencilKernels::relaxInteriorSpan(p, rhs, rr.run, x0, dx, dy, dl1)
+			: StencilKernels::relaxSpan(p, rhs, relaxMask, invDiag, rr.run, x0, dx, dy, dl1);
 	}
-	else
+	return dl1;
+}
+
+template <typename T>
+void SimulatorClassic::relaxSweeps(Grid<T> &p, const Grid<T> &rhs, const Grid<T> &invDiag, const uint32_t sweeps)
+{
+	// the stage s is the half-sweep of the color s % 2 of the sweep s / 2
+	const uint32_t stages = 2 * sweeps;
+	auto relaxStage = [this, &p, &rhs, &invDiag, stages](const uint32_t s, const uint32_t y)
+	{
+		const uint32_t color = s % 2;
+		if (s + 2 >= stages)
+			rowDl1[y] = relaxHalfSweepRow(p, rhs, invDiag, y, color, color == 0 ? 0 : rowDl1[y]);
+		else
+			relaxHalfSweepRow(p, rhs, invDiag, y, color, 0);
+	};
+	if (sweeps == 1)
 	{
-		for (uint32_t y = 0; y < hp; y++)
-			u(wp - 1, y) = u(wp - 2, y);
+		// the points of one color only depend on the points of the other one,
+		// so each half-sweep can be computed by the bands in parallel with the same result as sequentially
+		for (uint32_t color = 0; color < 2; color++)
+		{
+			forEachBand([&relaxStage, color](uint32_t, const uint32_t y0, const uint32_t y1)
+			{
+				const SubnormalFlushGuard flush(std::is_same<T, float>::value);
+				for (uint32_t y = y0; y < y1; y++)
+					relaxStage(color, y);
+			});
+		}
+		return;
 	}
-	if (bcy0.utype == BoundaryCondType::Dirichlet)
+	// the stage s of a row reads the rows next to it after the stage s - 1 and must precede the stage s + 1 of both of them,
+	// which holds when the stage s is computed on the row t - s at the time t (and the stages of the same time in increasing order)
+	forEachBand([this, &relaxStage, stages](uint32_t, const uint32_t y0, const uint32_t y1)
 	{
-		for (uint32_t x = 0; x < wp; x++)
-			u(x, 0) = bcy0.u;
+		const SubnormalFlushGuard flush(std::is_same<T, float>::value);
+		// next to the border with a neighboring band, each stage is computed on one row fewer than the previous one
+		const uint32_t shrink0 = y0 == 1 ? 0 : 1, shrink1 = y1 == hp - 1 ? 0 : 1;
+		for (uint32_t t = y0; t + 1 < y1 + stages; t++)
+		{
+			for (uint32_t s = 0; s < stages && s <= t; s++)
+			{
+				const uint32_t y = t - s;
+				if (y >= y0 + s * shrink0 && y + s * shrink1 < y1)
+					relaxStage(s, y);
+			}
+		}
+	});
+	// the rows y1 - s <= y < y1 + s around each border y1 between two bands that are still missing the stage s
+	forEachBand([this, &relaxStage, stages](uint32_t, uint32_t, const uint32_t y1)
+	{
+		if (y1 == hp - 1)
+			return;
+		const SubnormalFlushGuard flush(std::is_same<T, float>::value);
+		for (uint32_t s = 1; s < stages; s++)
+			for (uint32_t y = y1 - s; y < y1 + s; y++)
+				relaxStage(s, y);
+	});
+}
+
+double SimulatorClassic::relativeResidual()
+{
+	forEachBand([this](uint32_t, const uint32_t y0, const uint32_t y1)
+	{
+		for (uint32_t y = y0; y < y1; y++)
+		{
+			rowFieldSq[y] = 0;
+			rowResidualSq[y] = StencilKernels::residualRow(f1.p, field, relaxMask, y, dx, dy, rowFieldSq[y]);
+		}
+	});
+	double residualSq = 0, fieldSq = 0;
+	for (uint32_t y = 1; y < hp - 1; y++)
+	{
+		residualSq += rowResidualSq[y];
+		fieldSq += rowFieldSq[y];
 	}
-	else
+	return std::sqrt(fieldSq != 0 ? residualSq / fieldSq : residualSq);
+}
+
+double SimulatorClassic::correctPressure()
+{
+	forEachBand([this](uint32_t, const uint32_t y0, const uint32_t y1)
+	{
+		// the correction is zero at the points that aren't unknowns
+		for (uint32_t y = y0; y < y1; y++)
+		{
+			for (uint32_t x = 0; x < wp; x++)
+			{
+				f1.p(x, y) += correction(x, y);
+				correction(x, y) = 0;
+			}
+		}
+	});
+	forEachBand([this](uint32_t, const uint32_t y0, const uint32_t y1)
 	{
-		for (uint32_t x = 0; x < wp; x++)
-			u(x, 0) = u(x, 1);
+		for (uint32_t y = y0; y < y1; y++)
+		{
+			rowFieldSq[y] = 0;
+			rowResidualSq[y] = StencilKernels::residualRow(f1.p, field, relaxMask, y, dx, dy, rowFieldSq[y], correctionRhs);
+		}
+	});
+	double residualSq = 0, fieldSq = 0;
+	for (uint32_t y = 1; y < hp - 1; y++)
+	{
+		residualSq += rowResidualSq[y];
+		fieldSq += rowFieldSq[y];
 	}
-	if (bcy1.utype == BoundaryCondType::Dirichlet)
+	return std::sqrt(fieldSq != 0 ? residualSq / fieldSq : residualSq);
+}
+
+void SimulatorClassic::enforcePBoundary(Grid<double>& p)
+{
+	(this->*enforcePBoundaryFn)(p);
+}
+
+void SimulatorClassic::enforceUBoundary(Vec2dGrid& u)
+{
+	(this->*enforceUBoundaryFn)(u);
+}
+
+void SimulatorClassic::enforceUBoundaryRow(Vec2dGrid& u, const uint32_t y)
+{
+	(this->*enforceUBoundaryRowsFn)(u, y, y + 1);
+}
+
+void SimulatorClassic::computeIntermediateVelocityRow(const uint32_t y)
+{
+	if (spanIteration)
 	{
-		for (uint32_t x = 0; x < wp; x++)
-			u(x, hp - 1) = bcy1.u;
+		const vec<GridRun> &runs = geometry->indepRuns;
+		for (uint32_t r = geometry->indepRowRuns[y]; r < geometry->indepRowRuns[y + 1]; r++)
+			StencilKernels::advectDiffuseSpan(f0.u, ww, runs[r], dt, nu, dx, dy);
 	}
 	else
+		StencilKernels::advectDiffuseRow(f0.u, indep, ww, y, dt, nu, dx, dy);
+	// the kernels only write the independent points, so the w field stays zero at the obstacle boundary points (as required by the no-slip b.c.)
+	// and only the edges need the b.c. enforced
+	enforceUBoundaryRow(ww, y);
+}
+
+void SimulatorClassic::computeSemiLagrangianRow(const uint32_t y)
+{
+	const bool cubic = advection == AdvectionSemiLagrangianCubic;
+	if (spanIteration)
 	{
-		for (uint32_t x = 0; x < wp; x++)
-			u(x, hp - 1) = u(x, hp - 2);
+		const vec<GridRun> &runs = geometry->indepRuns;
+		for (uint32_t r = geometry->indepRowRuns[y]; r < geometry->indepRowRuns[y + 1]; r++)
+			StencilKernels::semiLagrangianSpan(f0.u, solid, ww, runs[r], dt, dx, dy, cubic);
 	}
+	else
+		StencilKernels::semiLagrangianRow(f0.u, solid, indep, ww, y, dt, dx, dy, cubic);
+	enforceUBoundaryRow(ww, y);
+}
 
-	// at obstacle boundaries, the velocity is given as (0, 0) by the no-slip condition
+void SimulatorClassic::solveViscousStep()
+{
+	// the advected velocity is both the RHS and the initial guess
+	forEachBand([this](uint32_t, const uint32_t y0, const uint32_t y1)
+	{
+		for (uint32_t y = y0; y < y1; y++)
+		{
+			std::copy_n(ww.xRow(y), wp, advected.xRow(y));
+			std::copy_n(ww.yRow(y), wp, advected.yRow(y));
+			double l1 = 0;
+			for (uint32_t x = 1; x < wp - 1; x++)
+				l1 += indep(x, y) ? std::abs(ww.xRow(y)[x]) + std::abs(ww.yRow(y)[x]) : 0;
+			rowAdvectedL1[y] = l1;
+		}
+	});
+	double advectedL1 = 0;
 	for (uint32_t y = 1; y < hp - 1; y++)
+		advectedL1 += rowAdvectedL1[y];
+	for (uint32_t sweep = 0; sweep < ViscousSweepCap; sweep++)
 	{
-		for (uint32_t x = 1; x < wp - 1; x++)
+		// the points of one color only depend on the points of the other one, so the bands can update them in parallel
+		for (uint32_t color = 0; color < 2; color++)
 		{
-			if (!solid(x, y) && !indep(x, y))
-				u(x, y) = vec2d(0, 0);
+			forEachBand([this, color](uint32_t, const uint32_t y0, const uint32_t y1)
+			{
+				for (uint32_t y = y0; y < y1; y++)
+				{
+					double dl1 = color == 0 ? 0 : rowDl1[y];
+					// the first point of the row with the color of the half-sweep
+					const uint32_t x0 = 2 - (y + color) % 2;
+					if (spanIteration)
+					{
+						const vec<GridRun> &runs = geometry->indepRuns;
+						for (uint32_t r = geometry->indepRowRuns[y]; r < geometry->indepRowRuns[y + 1]; r++)
+							dl1 = StencilKernels::viscousRelaxSpan(ww, advected, runs[r], x0, dt, nu, dx, dy, dl1);
+					}
+					else
+						dl1 = StencilKernels::viscousRelaxRow(ww, advected, indep, y, x0, dt, nu, dx, dy, dl1);
+					rowDl1[y] = dl1;
+				}
+			});
 		}
+		// the Neumann b.c. follow the updated inner points
+		enforceUBoundary(ww);
+		double dl1 = 0;
+		for (uint32_t y = 1; y < hp - 1; y++)
+			dl1 += rowDl1[y];
+		if (dl1 <= ViscousTolerance * advectedL1)
+			break;
 	}
 }
 
+bool SimulatorClassic::computeDivergenceRow(const uint32_t y)
+{
+	if (!spanIteration)
+		return StencilKernels::divergenceRow(ww, indep, field, y, rho, dt, dx, dy, crashLimit);
+	const vec<GridRun> &runs = geometry->indepRuns;
+	bool rowCrashed = false;
+	for (uint32_t r = geometry->indepRowRuns[y]; r < geometry->indepRowRuns[y + 1]; r++)
+		rowCrashed |= StencilKernels::divergenceSpan(ww, field, runs[r], rho, dt, dx, dy, crashLimit);
+	return rowCrashed;
+}
+
 void SimulatorClassic::enforceBoundary(SimFrame& f)
 {
 	enforcePBoundary(f.p);
 	enforceUBoundary(f.u);
 }
 
+void SimulatorClassic::extrapolatePressure()
+{
+	// after the swap, f0.p holds the pressure of the last step, f1.p that of the step before it and olderP the one before that
+	const bool quadratic = pressureExtrapolation == PressureExtrapolationQuadratic;
+	if (quadratic)
+		std::swap(olderP, f1.p);
+	const uint32_t order = std::min(uint32_t(pressureExtrapolation), pressureHistory - 1);
+	const uint32_t n = wp * hp;
+	const double *const last = f0.p.data;
+	// the pressure of the step before the last one (kept in olderP for the next step when extrapolating quadratically)
+	const double *const prev = quadratic ? olderP.data : f1.p.data;
+	// holds the pressure of the step before prev when extrapolating quadratically
+	double *const next = f1.p.data;
+	if (order == 0)
+		std::copy(last, last + n, next);
+	else if (order == 1)
+	{
+		const double r = dt / lastDt;
+		for (uint32_t i = 0; i < n; i++)
+			next[i] = last[i] + r * (last[i] - prev[i]);
+	}
+	else
+	{
+		// with the times relative to that of last in the units of lastDt, the fields are at 0, -1, and -(1 + b) and the guess at a;
+		// the weights are exactly 3, -3, and 1 with a uniform step
+		const double a = dt / lastDt, b = prevDt / lastDt;
+		const double w0 = (a + 1) * (a + 1 + b) / (1 + b);
+		const double w1 = -a * (a + 1 + b) / b;
+		const double w2 = a * (a + 1) / (b * (1 + b));
+		for (uint32_t i = 0; i < n; i++)
+			next[i] = w0 * last[i] + w1 * prev[i] + w2 * next[i];
+	}
+}
+
+void SimulatorClassic::adaptTimeStep()
+{
+	// the upwind advection with the explicit diffusion is stable iff dt * (|u_x| / dx + |u_y| / dy + 2 nu (1 / dx^2 + 1 / dy^2)) <= 1 at every point;
+	// the semi-Lagrangian advection with the implicit diffusion is stable with any step, and the Courant number only bounds the length of the traced paths
+	forEachBand([this](uint32_t, const uint32_t y0, const uint32_t y1)
+	{
+		// the first and the last band also cover the edge rows
+		const double rdx = 1 / dx, rdy = 1 / dy;
+		for (uint32_t y = y0 == 1 ? 0 : y0; y < (y1 == hp - 1 ? hp : y1); y++)
+		{
+			const double *const ux = f0.u.xRow(y);
+			const double *const uy = f0.u.yRow(y);
+			double mx = 0;
+			for (uint32_t x = 0; x < wp; x++)
+				mx = std::max(mx, std::abs(ux[x]) * rdx + std::abs(uy[x]) * rdy);
+			rowMaxRate[y] = mx;
+		}
+	});
+	const double viscousRate = advection == AdvectionUpwind ? 2 * nu * (1 / (dx * dx) + 1 / (dy * dy)) : 0;
+	// the upwind scheme is unstable above 1 whatever bound has been set
+	const double maxCourantNumber = advection == AdvectionUpwind ? std::min(courantNumber, 1.) : courantNumber;
+	// the step is maxDt if the rate is zero
+	const double rate = *std::max_element(rowMaxRate.begin(), rowMaxRate.end()) + viscousRate;
+	dt = std::clamp(maxCourantNumber / rate, minDt, maxDt);
+	// the simulation time left until stepUntil (which is ignored unless it's ahead)
+	const double left = stepUntil - time;
+	if (left > 0 && left <= dt)
+	{
+		// land exactly on stepUntil
+		dt = left;
+		stepEndTime = stepUntil;
+		return;
+	}
+	if (left > 0 && left < 2 * dt)
+		dt = left / 2;
+	stepEndTime = time + dt;
+}
+
 void SimulatorClassic::iter()
 {
 	if (crashed)
 		return;
 	if (!incomplete)
 	{
-		f0 = f1;
-		// compute the w field
-		for (uint32_t y = 1; y < hp - 1; y++)
+		// swap the buffers instead of copying the whole frame: the velocity field of f1 is entirely recomputed
+		// (the projection writes the independent points, the b.c. enforcement all other non-solid points, and the solid ones stay zero),
+		// so only the pressure has to be carried over (as the initial guess of the solver)
+		std::swap(f0, f1);
+		if (timeStepping == TimeSteppingAdaptive)
+			adaptTimeStep();
+		else
+			stepEndTime = time + dt;
+		extrapolatePressure();
+		stepIterations = 0;
+		if (advection == AdvectionUpwind)
 		{
-			for (uint32_t x = 1; x < wp - 1; x++)
+			// compute the w field and the RHS of the Poisson equation for pressure in a single pass over the rows:
+			// the RHS of a row is computed right after the last row of w it depends on, while the rows are still in the cache.
+			// Each band computes its rows of w and the edge rows next to them, so the RHS of a row at the border of a band
+			// that depends on a row of w of the neighboring band is left for a second pass after all the bands are done
+			const auto inlineDivergenceRows = [this](const uint32_t y0, const uint32_t y1)
 			{
-				if (indep(x, y))
+				return std::make_pair(y0 == 1 ? 1 : y0 + 1, y1 == hp - 1 ? y1 : y1 - 1);
+			};
+			forEachBand([this, &inlineDivergenceRows](const uint32_t b, const uint32_t y0, const uint32_t y1)
+			{
+				const auto [d0, d1] = inlineDivergenceRows(y0, y1);
+				for (uint32_t y = y0; y < y1; y++)
 				{
-					// viscous term (laplacian of u)
-					const vec2d lapu = (f0.u(x + 1, y) - 2 * f0.u(x, y) + f0.u(x - 1, y)) / (dx * dx)
-						+ (f0.u(x, y + 1) - 2 * f0.u(x, y) + f0.u(x, y - 1)) / (dy * dy);
-					/*const vec2d convec = f0.u(x, y).x * (f0.u(x + 1, y) - f0.u(x - 1, y)) / (2 * dx)
-						+ f0.u(x, y).y * (f0.u(x, y + 1) - f0.u(x, y - 1)) / (2 * dy);*/
-					// convective term of u (using upwind differencing)
-					const vec2d convec = f0.u(x, y).x * (f0.u(x, y).x > 0 ? f0.u(x, y) - f0.u(x - 1, y) : f0.u(x + 1, y) - f0.u(x, y)) / dx
-						+ f0.u(x, y).y * (f0.u(x, y).y > 0 ? f0.u(x, y) - f0.u(x, y - 1) : f0.u(x, y + 1) - f0.u(x, y)) / dy;
-					ww(x, y) = f0.u(x, y) + dt * (nu * lapu - convec);
+					computeIntermediateVelocityRow(y);
+					if (y == 1)
+						enforceUBoundaryRow(ww, 0);
+					if (y == hp - 2)
+						enforceUBoundaryRow(ww, hp - 1);
+					// the rows of the RHS whose last row of w is complete now
+					const uint32_t last = y == hp - 2 ? y : y - 1;
+					for (uint32_t d = std::max(y - 1, d0); d <= last && d < d1; d++)
+					{
+						if (computeDivergenceRow(d))
+						{
+							bandCrashed[b] = true;
+							return;
+						}
+					}
 				}
-			}
+			});
+			forEachBand([this, &inlineDivergenceRows](const uint32_t b, const uint32_t y0, const uint32_t y1)
+			{
+				const auto [d0, d1] = inlineDivergenceRows(y0, y1);
+				for (uint32_t y = y0; y < y1 && !bandCrashed[b]; y++)
+				{
+					if ((y < d0 || y >= d1) && computeDivergenceRow(y))
+						bandCrashed[b] = true;
+				}
+			});
 		}
-		enforceUBoundary(ww);
-		// compute the RHS of the Poisson equation for pressure
-		for (uint32_t y = 1; y < hp - 1; y++)
+		else
 		{
-			for (uint32_t x = 1; x < wp - 1; x++)
+			// the implicit viscous step needs the whole advected w field, so the RHS is computed in a separate pass
+			forEachBand([this](uint32_t, const uint32_t y0, const uint32_t y1)
+			{
+				for (uint32_t y = y0; y < y1; y++)
+					computeSemiLagrangianRow(y);
+			});
+			enforceUBoundaryRow(ww, 0);
+			enforceUBoundaryRow(ww, hp - 1);
+			if (nu > 0)
+				solveViscousStep();
+			forEachBand([this](const uint32_t b, const uint32_t y0, const uint32_t y1)
 			{
-				if (indep(x, y))
+				for (uint32_t y = y0; y < y1; y++)
 				{
-					field(x, y) = rho / dt * ((ww(x + 1, y).x - ww(x - 1, y).x) / (2 * dx) + (ww(x, y + 1).y - ww(x, y - 1).y) / (2 * dy)); 
-					if (field(x, y) > crashLimit || field(x, y) < -crashLimit)
+					if (computeDivergenceRow(y))
 					{
-						crashed = true;
+						bandCrashed[b] = true;
 						return;
 					}
 				}
-			}
+			});
+		}
+		if (collectBandCrashes())
+		{
+			crashed = true;
+			return;
 		}
 	}
 	incomplete = false;
-	uint32_t it = 0;
+	// relative residual of the solution (negative until computed)
+	double residual = -1;
 	// solve the Poisson equation for pressure
-	while (true)
+	if (pressureSolver)
 	{
-		//f0.p = f1.p;
-		double dl1 = 0;
-		for (uint32_t y = 1; y < hp - 1; y++)
+		// the solver reads the values at the Dirichlet points from the pressure field, so set them first
+		enforcePBoundary(f1.p);
+		const uint64_t iterationsBefore = pressureSolver->getIterationCount();
+		const PressureSolveResult res = pressureSolver->solve(f1.p, field, [this]{ return pauseRequested(); });
+		stepIterations += pressureSolver->getIterationCount() - iterationsBefore;
+		if (res == PressureSolveResult::Diverged)
 		{
-			for (uint32_t x = 1; x < wp - 1; x++)
-			{
-				if (indep(x, y) && !dirichlet(x, y))
-				{
-					double sm = 0;
-					double coef = 2 * dx * dx + 2 * dy * dy;
-					if (indep(x + 1, y) || dirichlet(x + 1, y))
-						sm += dy * dy * f1.p(x + 1, y);
-					else
-						coef -= dy * dy;
-					if (indep(x - 1, y) || dirichlet(x - 1, y))
-						sm += dy * dy * f1.p(x - 1, y);
-					else
-						coef -= dy * dy;
-					if (indep(x, y + 1) || dirichlet(x, y + 1))
-						sm += dx * dx * f1.p(x, y + 1);
-					else
-						coef -= dx * dx;
-					if (indep(x, y - 1) || dirichlet(x, y - 1))
-						sm += dx * dx * f1.p(x, y - 1);
-					else
-						coef -= dx * dx;
-					const double newval = (sm - (dx * dx) * (dy * dy) * field(x, y)) / coef * 1.5 - .5 * f1.p(x, y);
-					dl1 += abs(f1.p(x, y) - newval);
-					f1.p(x, y) = newval;
-				}
-			}
+			crashed = true;
+			return;
 		}
-		if (std::isnan(dl1))
+		if (res == PressureSolveResult::Interrupted)
 		{
-			crashed = true;
+			incomplete = true;
 			return;
 		}
 		enforcePBoundary(f1.p);
-		if (dl1 < lapL1limit)
-			break;
-		it++;
-		if (it == 1000)
+	}
+	else
+	{
+		// over-relaxation in the red-black (checkerboard) order;
+		// the relaxation neither modifies nor reads the points whose pressure is set by the b.c. other than the Dirichlet ones (which are constant),
+		// so the b.c. only need to be enforced before and after the sweeps
+		enforcePBoundary(f1.p);
+		// in the mixed precision, the sweeps relax the correction of the pressure (adding any correction left from an interrupted solving first)
+		const bool mixed = relaxationPrecision == RelaxationPrecisionMixed;
+		if (mixed)
+			residual = correctPressure();
+		uint32_t it = 0;
+		while (true)
 		{
-			it = 0;
-			if (controlMutex)
+			// end the blocks of sweeps at the cap and at the checks of the residual,
+			// the change criterion is checked on the last sweep of a block (so it may do up to blockSweeps - 1 more sweeps than necessary)
+			uint32_t sweeps = uint32_t(std::min<uint64_t>(blockSweeps, std::max<uint64_t>(iterationCap, stepIterations + 1) - stepIterations));
+			if (stopCriterion == PressureStopResidual || mixed)
+				sweeps = std::min(sweeps, residualCheckPeriod - uint32_t(stepIterations % residualCheckPeriod));
+			if (mixed)
+				relaxSweeps(correction, correctionRhs, relaxInvDiagSingle, sweeps);
+			else
+				relaxSweeps(f1.p, field, relaxInvDiag, sweeps);
+			double dl1 = 0;
+			for (uint32_t y = 1; y < hp - 1; y++)
+				dl1 += rowDl1[y];
+			if (std::isnan(dl1))
+			{
+				crashed = true;
+				return;
+			}
+			stepIterations += sweeps;
+			const bool periodEnd = stepIterations % residualCheckPeriod == 0;
+			if (mixed && periodEnd)
+				residual = correctPressure();
+			if (stopCriterion == PressureStopChange && dl1 < lapL1limit)
+				break;
+			if (stopCriterion == PressureStopResidual && periodEnd)
 			{
-				controlMutex->lock();
-				if (*pauseSignal)
+				if (!mixed)
+					residual = relativeResidual();
+				if (residual <= relResidualLimit)
+					break;
+			}
+			// the cap bounds the time of a step at the cost of the accuracy of the pressure
+			if (stepIterations >= iterationCap)
+				break;
+			it += sweeps;
+			if (it >= 1000)
+			{
+				it = 0;
+				if (pauseRequested())
 				{
 					incomplete = true;
-					controlMutex->unlock();
 					return;
 				}
-				controlMutex->unlock();
 			}
 		}
+		if (mixed && stepIterations % residualCheckPeriod != 0)
+			residual = correctPressure();
+		enforcePBoundary(f1.p);
 	}
+	if (residual < 0)
+		residual = relativeResidual();
 	// update the velocity field using the computed pressure
-	for (uint32_t y = 1; y < hp - 1; y++)
+	forEachBand([this](const uint32_t b, const uint32_t y0, const uint32_t y1)
 	{
-		for (uint32_t x = 1; x < wp - 1; x++)
+		const vec<GridRun> &runs = geometry->indepRuns;
+		for (uint32_t y = y0; y < y1; y++)
 		{
-			if (indep(x, y))
+			bool rowCrashed = false;
+			if (spanIteration)
+				for (uint32_t r = geometry->indepRowRuns[y]; r < geometry->indepRowRuns[y + 1]; r++)
+					rowCrashed |= StencilKernels::projectSpan(ww, f1.p, f1.u, runs[r], rho, dt, dx, dy);
+			else
+				rowCrashed = StencilKernels::projectRow(ww, f1.p, indep, f1.u, y, rho, dt, dx, dy);
+			if (rowCrashed)
 			{
-				f1.u(x, y).x = ww(x, y).x - dt / rho * (f1.p(x + 1, y) - f1.p(x - 1, y)) / (2 * dx);
-				f1.u(x, y).y = ww(x, y).y - dt / rho * (f1.p(x, y + 1) - f1.p(x, y - 1)) / (2 * dy);
-				if (std::isnan(f1.u(x, y).x) || std::isnan(f1.u(x, y).y))
-				{
-					crashed = true;
-					return;
-				}
+				bandCrashed[b] = true;
+				return;
 			}
 		}
+	});
+	if (collectBandCrashes())
+	{
+		crashed = true;
+		return;
 	}
 	enforceBoundary(f1);
+	f1.pressureIterations = stepIterations;
+	f1.pressureResidual = residual;
+	f1.dt = dt;
+	time = stepEndTime;
+	computedSteps++;
+	pressureIterations += stepIterations;
+	pressureHistory = std::min(pressureHistory + 1, 3u);
+	prevDt = lastDt;
+	lastDt = dt;
+}
+
+uint64_t SimulatorClassic::getSolverMemoryFootprint() const
+{
+	return pressureSolver ? pressureSolver->getMemoryFootprint() : 0;
 }
 
 }
\ No newline at end of file
@@ -7,50 +7,295 @@
 #ifndef SIMULATOR_CLASSIC_HPP
 #define SIMULATOR_CLASSIC_HPP
 
+#include <functional>
+
+#include "pressure-solver.hpp"
+#include "ptr.hpp"
 #include "simulator.hpp"
+#include "tests.hpp"
+#include "thread-pool.hpp"
+#include "vec.hpp"
 
 namespace brandy0
 {
 
+/**
+ * Run of unknowns of the pressure relaxation in a row, either all of them interior (@see RelaxInterior) or none of them
+ */
+struct RelaxationRun
+{
+	/// Points of the run
+	GridRun run;
+	/// True iff the points of the run are interior unknowns
+	bool interior;
+};
+
 class SimulatorClassic : public Simulator
 {
+friend Tests;
 private:
 	/// Grid for the 'w' field (divergence of the intermediate velocity)
-	Grid<vec2d> ww;
+	Vec2dGrid ww;
 	/// Grid for the RHS of the Poisson equation for pressure
 	Grid<double> field;
-	/**
-	 * Grid in which a point is true iff the value of pressure there is set directly by a Dirichlet boundary condition
-	 * (or arbitrarily because it didn't connect to any point with set pressure and the pressure field is determined up to a constant)
-	 */
-	Grid<bool> dirichlet;
-	/**
-	 * Grid marking points as visited for the purposes of a search that identifies isolated components to set constant pressure values there
-	 */
-	Grid<bool> visited;
+	/// Grid in which a point is true iff the value of pressure there is set directly by a Dirichlet boundary condition or arbitrarily (@see DomainGeometry::dirichlet)
+	const BitGrid &dirichlet;
+	/// Per-point masks of RelaxationStencilBit values describing the stencil of the built-in relaxation (computed once in the constructor)
+	Grid<uint8_t> relaxMask;
+	/// Per-point reciprocals of the diagonal coefficients of the Poisson equation for pressure for the built-in relaxation (0 at the points that aren't unknowns)
+	Grid<double> relaxInvDiag;
+
+	/// Runs of the unknowns of the relaxation split into the interior ones and the ones at the boundaries (in the row major order)
+	vec<RelaxationRun> relaxRuns;
+	/// Index of the first run of each row in relaxRuns (with an extra entry past the last row)
+	vec<uint32_t> relaxRowRuns;
 
 	/**
-	 * Marks the specified point as visited and calls itself on its (direct -- at most 4) neighbors.
-	 * Does nothing if the specified point was already marked as visited.
-	 * @param p grid point to visit
+	 * Computes relaxMask, relaxInvDiag, relaxRuns, and relaxRowRuns from indep and dirichlet
 	 */
-	void visit(Point p);
+	void buildRelaxationStencil();
 
 	/// Upper bound on the L1 norm of the change of the pressure field for the solving of the Poisson equation for pressure to stop
 	double lapL1limit;
+	/// Upper bound on the ratio of the L2 norms of the residual and of the RHS for the solving of the Poisson equation for pressure to stop
+	/// (used by the conjugate gradient solver and by the relaxation with the residual stopping criterion)
+	double relResidualLimit;
+	/// Rule by which the built-in relaxation decides that the Poisson equation for pressure is solved
+	PressureStopCriterion stopCriterion;
+	/// Number of sweeps of the relaxation between two checks of the residual stopping criterion
+	uint32_t residualCheckPeriod;
+	/// Cap on the number of iterations of the solving of the Poisson equation for pressure in one step (the sweeps of the relaxation,
+	/// also passed to the iterative solvers)
+	uint32_t iterationCap;
+	/// Solver of the Poisson equation for pressure. Null iff the equation should be solved by the relaxation built into the iter method
+	uptr<PressureSolver> pressureSolver;
 	/// Upper bound for the value of the RHS in the Poisson equation for pressure at any point such that the simulation is not declared as divergent (crashed)
 	double crashLimit;
 
+	/// Initial guess of the pressure field in each step
+	PressureExtrapolation pressureExtrapolation;
+	/// Pressure field of the step before the one of f1 (only allocated for the quadratic extrapolation)
+	Grid<double> olderP;
+	/// Number of the most recent pressure fields available for the extrapolation (at most 3: in f1, f0, and olderP)
+	uint32_t pressureHistory;
+	/// Time step of the last computed step, i.e. between the two most recent pressure fields in the history
+	double lastDt;
+	/// Time step of the step before the last one, i.e. between the second and the third most recent pressure fields in the history
+	double prevDt;
+	/// Number of iterations of the solving of the Poisson equation for pressure in the step being computed
+	uint64_t stepIterations;
+
+	/// Floating-point precision of the sweeps of the built-in relaxation
+	RelaxationPrecision relaxationPrecision;
+	/// Correction of the pressure in f1 relaxed in the mixed precision (only allocated for that precision)
+	Grid<float> correction;
+	/// RHS of the equation for the correction, i.e. the negated residual of the pressure in f1 (only allocated for the mixed precision)
+	Grid<float> correctionRhs;
+	/// Single-precision copy of relaxInvDiag (only allocated for the mixed precision)
+	Grid<float> relaxInvDiagSingle;
+
+	/**
+	 * Adds the correction to the pressure in f1, resets it to zero, and computes the RHS of the equation for the next correction
+	 * (in parallel over the bands)
+	 * @return ratio of the L2 norms of the residual and of the RHS at the unknowns after the correction (@see relativeResidual)
+	 */
+	double correctPressure();
+
+	/**
+	 * Sets f1.p to the initial guess of the pressure field for the step being started (after the frames have been swapped and dt has been set)
+	 * by the Lagrange extrapolation to its end time from the times of the fields in the history (so the weights follow a variable time step)
+	 * and moves the older pressure fields along in the history
+	 */
+	void extrapolatePressure();
+
+	/// Minimum average length of the runs of independent points for the automatic cell iteration mode to iterate over the runs (@see CellIterationMode)
+	static constexpr double MinAverageRunLength = 8;
+	/// True iff the stencil passes iterate only over the runs of independent points instead of over whole rows
+	bool spanIteration;
+
+	/// Minimum number of grid points per row band for the computation to be split into multiple bands
+	static constexpr uint32_t MinBandPoints = 4096;
+	/// Pool of threads computing the row bands in parallel
+	ThreadPool pool;
+	/// Number of bands the inner rows of the grid are split into for the parallel computation
+	uint32_t bandCount;
+	/// Per-row partial sums of the L1 norm of the pressure change during a relaxation sweep (summed in a fixed order for a deterministic result)
+	vec<double> rowDl1;
+	/// Per-band flags set when the simulation has crashed during the computation of the band
+	vec<uint8_t> bandCrashed;
+	/// Per-row squared L2 norms of the residual of the Poisson equation for pressure (@see relativeResidual)
+	vec<double> rowResidualSq;
+	/// Per-row squared L2 norms of the RHS of the Poisson equation for pressure at the unknowns (@see relativeResidual)
+	vec<double> rowFieldSq;
+	/// Per-row maxima of |u_x| / dx + |u_y| / dy (@see adaptTimeStep)
+	vec<double> rowMaxRate;
+	/// Simulation time at the end of the step being computed
+	double stepEndTime;
+
+	/**
+	 * Sets dt of the step being started (after the frames have been swapped) in the adaptive time stepping and sets stepEndTime.
+	 * The step is as long as the Courant number allows within minDt and maxDt, shortened so that it doesn't pass stepUntil
+	 * (and split into two halves if a full step would leave a shorter remainder before stepUntil)
+	 */
+	void adaptTimeStep();
+
+	/// Discretization of the convective and the viscous term
+	AdvectionScheme advection;
+	/// Velocity advected by the semi-Lagrangian scheme, i.e. the RHS of the implicit viscous step (only allocated for that scheme with a nonzero viscosity)
+	Vec2dGrid advected;
+	/// Per-row L1 norms of the advected velocity at the independent points (@see solveViscousStep)
+	vec<double> rowAdvectedL1;
+	/// Upper bound on the ratio of the L1 norms of the change of the velocity in a sweep and of the advected velocity for the implicit viscous step to stop
+	static constexpr double ViscousTolerance = 1e-10;
+	/// Cap on the number of sweeps of the implicit viscous step
+	static constexpr uint32_t ViscousSweepCap = 1000;
+
+	/**
+	 * Computes an inner row of the w field advected by the semi-Lagrangian scheme (without the viscous term)
+	 * and enforces the boundary conditions for velocity at its edges
+	 * @param y index of the row
+	 */
+	void computeSemiLagrangianRow(uint32_t y);
+	/**
+	 * Applies the implicit viscous step to the advected w field, i.e. solves w - dt * nu * laplacian(w) = (advected w)
+	 * by the red-black Gauss-Seidel iteration (in parallel over the bands), which converges for any time step
+	 */
+	void solveViscousStep();
+
+	/// Number of sweeps of the relaxation applied to the rows in a single pass over the grid when the grid doesn't fit in the cache
+	static constexpr uint32_t TemporalBlockSweeps = 4;
+	/// Minimum number of grid points for the sweeps of the relaxation to be blocked (the fields of smaller grids stay in the cache between the sweeps)
+	static constexpr uint64_t MinTemporalBlockingPoints = 1 << 19;
+	/// Number of sweeps of the relaxation computed in a single pass over the grid (either 1 or TemporalBlockSweeps, @see relaxSweeps)
+	uint32_t blockSweeps;
+
+	/**
+	 * Runs a function for every row band of the inner rows of the grid (concurrently, over the thread pool) and waits until all of them finish
+	 * @param fn function taking the index of the band and its first and past-the-last row
+	 */
+	void forEachBand(const std::function<void(uint32_t, uint32_t, uint32_t)> &fn);
+	/**
+	 * @return true iff the crash flag of any band has been set (the flags are cleared afterwards)
+	 */
+	bool collectBandCrashes();
+	/**
+	 * Performs one half-sweep of the built-in relaxation on an inner row
+	 * @tparam T type of the values of the fields (double, or float in the mixed precision)
+	 * @param p pressure field (or its correction) to update
+	 * @param rhs RHS of the Poisson equation (for the pressure or its correction)
+	 * @param invDiag reciprocals of the diagonal coefficients of the equation (@see relaxInvDiag)
+	 * @param y index of the row
+	 * @param color color of the points to update (the points with even x + y have color 0)
+	 * @param dl1 L1 norm of the change of the pressure accumulated so far
+	 * @return dl1 plus the L1 norm of the change of the pressure on the row
+	 */
+	template <typename T>
+	double relaxHalfSweepRow(Grid<T> &p, const Grid<T> &rhs, const Grid<T> &invDiag, uint32_t y, uint32_t color, double dl1);
+	/**
+	 * Performs several sweeps of the built-in relaxation (in parallel over the bands) and stores the L1 norms of the change
+	 * of the pressure on the rows in the last sweep into rowDl1 (@see relaxHalfSweepRow for the parameters p, rhs, and invDiag).
+	 * Multiple sweeps are computed in a single pass over the rows of each band: the half-sweep of each row follows
+	 * one row behind the previous half-sweep (so that the rows in between stay in the cache), and the rows next to the borders
+	 * of the bands, which need the rows of the neighboring bands, are left for a second pass after all the bands are done.
+	 * The results are the same as of the sweeps performed one after another
+	 * @param sweeps number of sweeps (a multi-sweep pass requires the bands to have at least 4 * sweeps rows)
+	 */
+	template <typename T>
+	void relaxSweeps(Grid<T> &p, const Grid<T> &rhs, const Grid<T> &invDiag, uint32_t sweeps);
+	/**
+	 * Computes the residual of the Poisson equation for pressure with the pressure in f1 (in parallel over the bands)
+	 * @return ratio of the L2 norms of the residual and of the RHS at the unknowns (the L2 norm of the residual if the RHS is zero)
+	 */
+	double relativeResidual();
+
+	/// Pointer to a specialization of enforcePBoundaryFor
+	using PBoundaryFn = void (SimulatorClassic::*)(Grid<double> &);
+	/// Pointer to a specialization of enforceUBoundaryFor
+	using UBoundaryFn = void (SimulatorClassic::*)(Vec2dGrid &);
+	/// Pointer to a specialization of enforceUBoundaryRowsFor
+	using UBoundaryRowsFn = void (SimulatorClassic::*)(Vec2dGrid &, uint32_t, uint32_t);
+	/// Specialization of enforcePBoundaryFor for the boundary conditions and the obstacles of the simulation (selected in the constructor)
+	PBoundaryFn enforcePBoundaryFn;
+	/// Specialization of enforceUBoundaryFor for the boundary conditions and the obstacles of the simulation (selected in the constructor)
+	UBoundaryFn enforceUBoundaryFn;
+	/// Specialization of enforceUBoundaryRowsFor for the boundary conditions of the simulation (selected in the constructor)
+	UBoundaryRowsFn enforceUBoundaryRowsFn;
+	/// Holds the pointer to a specialization of enforcePBoundaryFor as its static member fn
+	template <BoundaryCondType X0, BoundaryCondType X1, BoundaryCondType Y0, BoundaryCondType Y1, bool Obstacles>
+	struct PBoundarySpecialization;
+	/// Holds the pointer to a specialization of enforceUBoundaryFor as its static member fn
+	template <BoundaryCondType X0, BoundaryCondType X1, BoundaryCondType Y0, BoundaryCondType Y1, bool Obstacles>
+	struct UBoundarySpecialization;
+	/// Holds the pointer to a specialization of enforceUBoundaryRowsFor as its static member fn (the same for both values of Obstacles)
+	template <BoundaryCondType X0, BoundaryCondType X1, BoundaryCondType Y0, BoundaryCondType Y1, bool Obstacles>
+	struct UBoundaryRowsSpecialization;
+
+	/**
+	 * Sets enforcePBoundaryFn, enforceUBoundaryFn, and enforceUBoundaryRowsFn to the specializations matching the types of the boundary conditions
+	 * and whether there are any obstacle boundary points
+	 */
+	void selectBoundarySpecializations();
 	/**
 	 * Modifies the specified pressure field to comply with the boundary conditions for pressure
+	 * @tparam X0 type of the boundary condition for pressure at x = 0 (the same as bcx0.ptype)
+	 * @tparam X1 type of the boundary condition for pressure at x = w (the same as bcx1.ptype)
+	 * @tparam Y0 type of the boundary condition for pressure at y = 0 (the same as bcy0.ptype)
+	 * @tparam Y1 type of the boundary condition for pressure at y = h (the same as bcy1.ptype)
+	 * @tparam Obstacles false iff there are no obstacle boundary points
 	 * @param p pressure field to modify
 	 */
-	void enforcePBoundary(Grid<double> &p);
+	template <BoundaryCondType X0, BoundaryCondType X1, BoundaryCondType Y0, BoundaryCondType Y1, bool Obstacles>
+	void enforcePBoundaryFor(Grid<double> &p);
 	/**
 	 * Modifies the specified velocity field to comply with the boundary conditions for velocity
+	 * @tparam X0 type of the boundary condition for velocity at x = 0 (the same as bcx0.utype)
+	 * @tparam X1 type of the boundary condition for velocity at x = w (the same as bcx1.utype)
+	 * @tparam Y0 type of the boundary condition for velocity at y = 0 (the same as bcy0.utype)
+	 * @tparam Y1 type of the boundary condition for velocity at y = h (the same as bcy1.utype)
+	 * @tparam Obstacles false iff there are no obstacle boundary points
+	 * @param u velocity field to modify
+	 */
+	template <BoundaryCondType X0, BoundaryCondType X1, BoundaryCondType Y0, BoundaryCondType Y1, bool Obstacles>
+	void enforceUBoundaryFor(Vec2dGrid &u);
+	/**
+	 * Modifies the edge points of the rows y0 <= y < y1 of the specified velocity field to comply with the boundary conditions for velocity,
+	 * i.e. the points at x = 0 and x = w of the inner rows and all the points of the rows y = 0 and y = h (which are copied from the adjacent inner row
+	 * under a Neumann b.c., so that row has to be complete). The obstacle boundary points are left untouched
+	 * (@see enforceUBoundaryFor for the template parameters)
 	 * @param u velocity field to modify
+	 * @param y0 index of the first row
+	 * @param y1 index past the last row
 	 */
-	void enforceUBoundary(Grid<vec2d> &u);
+	template <BoundaryCondType X0, BoundaryCondType X1, BoundaryCondType Y0, BoundaryCondType Y1>
+	void enforceUBoundaryRowsFor(Vec2dGrid &u, uint32_t y0, uint32_t y1);
+	/**
+	 * Modifies the specified pressure field to comply with the boundary conditions for pressure (by the selected specialization of enforcePBoundaryFor)
+	 * @param p pressure field to modify
+	 */
+	void enforcePBoundary(Grid<double> &p);
+	/**
+	 * Modifies the specified velocity field to comply with the boundary conditions for velocity (by the selected specialization of enforceUBoundaryFor)
+	 * @param u velocity field to modify
+	 */
+	void enforceUBoundary(Vec2dGrid &u);
+	/**
+	 * Modifies the edge points of a row of the specified velocity field to comply with the boundary conditions for velocity
+	 * (by the selected specialization of enforceUBoundaryRowsFor)
+	 * @param u velocity field to modify
+	 * @param y index of the row
+	 */
+	void enforceUBoundaryRow(Vec2dGrid &u, uint32_t y);
+	/**
+	 * Computes an inner row of the w field and enforces the boundary conditions for velocity at its edges
+	 * @param y index of the row
+	 */
+	void computeIntermediateVelocityRow(uint32_t y);
+	/**
+	 * Computes an inner row of the RHS of the Poisson equation for pressure from the w field (whose rows y - 1, y, and y + 1 have to be complete)
+	 * @param y index of the row
+	 * @return true iff the RHS exceeds crashLimit in absolute value at some point of the row
+	 */
+	bool computeDivergenceRow(uint32_t y);
 	/**
 	 * Modifies both the pressure and the velocity field of a simulation frame to comply with the boundary conditions
 	 * @param f simulation frame to modify
@@ -59,9 +304,17 @@ private:
 public:
 	/**
 	 * Constructs a SimulatorClassic object
+	 * @param params simulation parameters for the simulation
+	 * @param geometry geometry of the simulated domain computed from params
+	 */
+	SimulatorClassic(const SimulationParams &params, sptr<const DomainGeometry> geometry);
+	/**
+	 * Constructs a SimulatorClassic object with its own geometry of the simulated domain
+	 * @param params simulation parameters for the simulation
 	 */
 	SimulatorClassic(const SimulationParams &params);
 	void iter() override;
+	uint64_t getSolverMemoryFootprint() const override;
 };
 
 }
@@ -9,7 +9,9 @@
 
 #include <mutex>
 
+#include "domain-geometry.hpp"
 #include "grid.hpp"
+#include "ptr.hpp"
 #include "sim-frame.hpp"
 #include "simulation-params.hpp"
 
@@ -34,16 +36,30 @@ public:
 	SimFrame f0;
 	/// Most current (latest computed) simulation frame
 	SimFrame f1;
+	/// Number of fully computed steps
+	uint64_t computedSteps = 0;
+	/// Total number of iterations of the solving of the Poisson equation for pressure in the fully computed steps (@see PressureSolver::getIterationCount)
+	uint64_t pressureIterations = 0;
+	/// Simulation time of f1
+	double time = 0;
+	/// Simulation time that the next step mustn't pass in the adaptive time stepping (set by the caller, so that the steps can land on the times of the frames;
+	/// ignored if it isn't after time)
+	double stepUntil = 0;
 	
 	/**
 	 * Constructs the Simulator objects for specified simulation parameters
 	 * @param params simulation parameters for the simulation
+	 * @param geometry geometry of the simulated domain computed from params
 	 */
-	Simulator(const SimulationParams &params);
+	Simulator(const SimulationParams &params, sptr<const DomainGeometry> geometry);
 	/**
 	 * Computes the next frame of the simulation (and stores it in the f1 attribute)
 	 */
 	virtual void iter() = 0;
+	/**
+	 * @return number of bytes of memory allocated by the solver of the Poisson equation for pressure (for its precomputed data and work space)
+	 */
+	virtual uint64_t getSolverMemoryFootprint() const = 0;
 	/**
 	 * Sets what variable and mutex should be used for pause signalling
 	 * @param pauseSignal pointer to the variable which signals pause
@@ -58,8 +74,22 @@ protected:
 	/// Mutex guarding the variable that pauseSignal points to
 	std::mutex *controlMutex = nullptr;
 
-	/// Simulation time step (dt)
+	/**
+	 * Checks (in a thread-safe way) whether the simulator has been signalled to pause
+	 * @return true iff the simulator should promptly pause (always false if no pause control has been set)
+	 */
+	bool pauseRequested() const;
+
+	/// Simulation time step (dt) of the step being computed
 	double dt;
+	/// Way the time step is chosen
+	TimeSteppingMode timeStepping;
+	/// Upper bound on the time step in the adaptive time stepping
+	double maxDt;
+	/// Lower bound on the time step in the adaptive time stepping
+	double minDt;
+	/// Upper bound on the Courant number in the adaptive time stepping (@see SimulationParams::courantNumber)
+	double courantNumber;
 	/// Simulation spacial step along the x axis (dx)
 	double dx;
 	/// Simulation spacial step along the y axis (dy)
@@ -74,10 +104,12 @@ protected:
 	double mu;
 	/// Fluid kinematic viscosity (nu)
 	double nu;
-	/// Grid in which a point is true iff not occupied by an obstacle
-	Grid<bool> solid;
-	/// Grid in which a point is true iff not solid and not at the boundary (i.e. it and all its 4 direct neighbors are non-solid) 
-	Grid<bool> indep;
+	/// Geometry of the simulated domain (shared with the frame drawers)
+	sptr<const DomainGeometry> geometry;
+	/// Grid in which a point is true iff occupied by an obstacle (@see DomainGeometry::solid)
+	const BitGrid &solid;
+	/// Grid in which a point is true iff not solid and not at the boundary (@see DomainGeometry::indep)
+	const BitGrid &indep;
 	/// Left boundary condition
 	BoundaryCond bcx0;
 	/// Right boundary condition
@@ -0,0 +1,537 @@
+/**
+ * stencil-kernels.cpp
+ *
+ * Author: Viktor Fukala
+ * Created on 2026/10/17
+ */
+#include "stencil-kernels.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace brandy0
+{
+
+/**
+ * @param mask words of a row of a BitGrid
+ * @param i x index of an entry
+ * @return 1 iff the entry is true (as an integer, so that it can be combined with other flags without branches)
+ */
+static inline uint8_t maskBit(const uint64_t *const __restrict mask, const uint32_t i)
+{
+	return mask[i / BitGrid::WordBits] >> (i % BitGrid::WordBits) & 1;
+}
+
+/**
+ * @tparam Masked false iff all the computed points are known to be independent (the mask isn't read then)
+ * @param mask words of a row of the grid of independent points (may be null if Masked is false)
+ * @param i x index of a point
+ * @return 1 iff the value computed at the point should be written
+ */
+template <bool Masked>
+static inline uint8_t isWritten(const uint64_t *const __restrict mask, const uint32_t i)
+{
+	return Masked ? maskBit(mask, i) : 1;
+}
+
+/**
+ * Computes the intermediate velocity on the points x0 <= x < x1 of a row given restrict-qualified pointers to the rows
+ * (@see StencilKernels::advectDiffuseRow)
+ */
+template <bool Masked>
+BRANDY0_TARGET_CLONES
+void advectDiffuse(const double *const __restrict ux, const double *const __restrict uy,
+	const double *const __restrict uxDown, const double *const __restrict uyDown,
+	const double *const __restrict uxUp, const double *const __restrict uyUp,
+	const uint64_t *const __restrict mask, double *const __restrict wwx, double *const __restrict wwy,
+	const uint32_t x0, const uint32_t x1, const double dt, const double nu, const double dx, const double dy)
+{
+	const double rdx2 = 1 / (dx * dx);
+	const double rdy2 = 1 / (dy * dy);
+	const double rdx = 1 / dx;
+	const double rdy = 1 / dy;
+	for (uint32_t i = x0; i < x1; i++)
+	{
+		const double cx = ux[i], cy = uy[i];
+		// viscous term (laplacian of u)
+		const double lapx = (ux[i + 1] - 2 * cx + ux[i - 1]) * rdx2 + (uxUp[i] - 2 * cx + uxDown[i]) * rdy2;
+		const double lapy = (uy[i + 1] - 2 * cy + uy[i - 1]) * rdx2 + (uyUp[i] - 2 * cy + uyDown[i]) * rdy2;
+		// convective term of u (using upwind differencing); both one-sided differences are computed and one of them is selected
+		const double gxx = cx > 0 ? cx - ux[i - 1] : ux[i + 1] - cx;
+		const double gxy = cx > 0 ? cy - uy[i - 1] : uy[i + 1] - cy;
+		const double gyx = cy > 0 ? cx - uxDown[i] : uxUp[i] - cx;
+		const double gyy = cy > 0 ? cy - uyDown[i] : uyUp[i] - cy;
+		const double convx = cx * gxx * rdx + cy * gyx * rdy;
+		const double convy = cx * gxy * rdx + cy * gyy * rdy;
+		const double wx = cx + dt * (nu * lapx - convx);
+		const double wy = cy + dt * (nu * lapy - convy);
+		const bool in = isWritten<Masked>(mask, i);
+		wwx[i] = in ? wx : wwx[i];
+		wwy[i] = in ? wy : wwy[i];
+	}
+}
+
+void StencilKernels::advectDiffuseRow(const Vec2dGrid &u, const BitGrid &indep, Vec2dGrid &ww, const uint32_t y,
+	const double dt, const double nu, const double dx, const double dy)
+{
+	advectDiffuse<true>(u.xRow(y), u.yRow(y), u.xRow(y - 1), u.yRow(y - 1), u.xRow(y + 1), u.yRow(y + 1),
+		indep.row(y), ww.xRow(y), ww.yRow(y), 1, u.w - 1, dt, nu, dx, dy);
+}
+
+void StencilKernels::advectDiffuseSpan(const Vec2dGrid &u, Vec2dGrid &ww, const GridRun &run,
+	const double dt, const double nu, const double dx, const double dy)
+{
+	const uint32_t y = run.y;
+	advectDiffuse<false>(u.xRow(y), u.yRow(y), u.xRow(y - 1), u.yRow(y - 1), u.xRow(y + 1), u.yRow(y + 1),
+		nullptr, ww.xRow(y), ww.yRow(y), run.x0, run.x1, dt, nu, dx, dy);
+}
+
+namespace
+{
+
+/**
+ * Cell of the grid containing a point given in the grid coordinates (x / dx, y / dy), with the position of the point within it
+ */
+struct GridCell
+{
+	/// x index of the lower left corner of the cell
+	uint32_t i;
+	/// y index of the lower left corner of the cell
+	uint32_t j;
+	/// Position of the point along the x axis relative to the cell (in [0, 1])
+	double fx;
+	/// Position of the point along the y axis relative to the cell (in [0, 1])
+	double fy;
+
+	/**
+	 * Constructs a GridCell structure
+	 * @param px x coordinate of the point (in [0, w - 1])
+	 * @param py y coordinate of the point (in [0, h - 1])
+	 * @param w width of the grid
+	 * @param h height of the grid
+	 */
+	GridCell(const double px, const double py, const uint32_t w, const uint32_t h)
+		: i(std::min(uint32_t(px), w - 2)), j(std::min(uint32_t(py), h - 2)), fx(px - i), fy(py - j)
+	{
+	}
+
+	/**
+	 * @param solid grid of solid points
+	 * @return true iff the bilinear interpolation in the cell reads the value at a solid point with a nonzero weight
+	 */
+	bool readsSolid(const BitGrid &solid) const
+	{
+		return (solid(i, j) && fx < 1 && fy < 1) || (solid(i + 1, j) && fx > 0 && fy < 1)
+			|| (solid(i, j + 1) && fx < 1 && fy > 0) || (solid(i + 1, j + 1) && fx > 0 && fy > 0);
+	}
+};
+
+}
+
+/**
+ * @return bilinear interpolation of one component of a vector grid given pointers to its rows j and j + 1
+ */
+static inline double lerp2(const double *const row0, const double *const row1, const GridCell &c)
+{
+	const double v0 = row0[c.i] + (row0[c.i + 1] - row0[c.i]) * c.fx;
+	const double v1 = row1[c.i] + (row1[c.i + 1] - row1[c.i]) * c.fx;
+	return v0 + (v1 - v0) * c.fy;
+}
+
+/**
+ * @return bilinear interpolation of the velocity in a cell
+ */
+static inline vec2d sampleLinear(const Vec2dGrid &u, const GridCell &c)
+{
+	return vec2d(lerp2(u.xRow(c.j), u.xRow(c.j + 1), c), lerp2(u.yRow(c.j), u.yRow(c.j + 1), c));
+}
+
+/**
+ * Computes the Catmull-Rom weights of the four points around a position
+ * @param t position relative to the two middle points (in [0, 1])
+ * @param wt weights of the points (output)
+ */
+static inline void cubicWeights(const double t, double *const wt)
+{
+	wt[0] = t * ((2 - t) * t - 1) / 2;
+	wt[1] = (t * t * (3 * t - 5) + 2) / 2;
+	wt[2] = t * ((4 - 3 * t) * t + 1) / 2;
+	wt[3] = (t - 1) * t * t / 2;
+}
+
+/**
+ * Computes the bicubic (Catmull-Rom) interpolation of the velocity in a cell limited to the range of the values at its corners
+ * (so that the advection can't create new extrema, which would make it unstable).
+ * The points of the 4 x 4 stencil outside the grid are replaced by the nearest ones on the grid
+ * @return the interpolated velocity, or the bilinear interpolation if the stencil contains a solid point
+ */
+static vec2d sampleCubic(const Vec2dGrid &u, const BitGrid &solid, const GridCell &c)
+{
+	uint32_t xs[4], ys[4];
+	for (uint32_t k = 0; k < 4; k++)
+	{
+		xs[k] = std::min(uint32_t(std::max(int64_t(c.i) + k - 1, int64_t(0))), u.w - 1);
+		ys[k] = std::min(uint32_t(std::max(int64_t(c.j) + k - 1, int64_t(0))), u.h - 1);
+	}
+	for (uint32_t b = 0; b < 4; b++)
+		for (uint32_t a = 0; a < 4; a++)
+			if (solid(xs[a], ys[b]))
+				return sampleLinear(u, c);
+	double wx[4], wy[4];
+	cubicWeights(c.fx, wx);
+	cubicWeights(c.fy, wy);
+	double vx = 0, vy = 0;
+	for (uint32_t b = 0; b < 4; b++)
+	{
+		const double *const rx = u.xRow(ys[b]), *const ry = u.yRow(ys[b]);
+		double sx = 0, sy = 0;
+		for (uint32_t a = 0; a < 4; a++)
+		{
+			sx += wx[a] * rx[xs[a]];
+			sy += wx[a] * ry[xs[a]];
+		}
+		vx += wy[b] * sx;
+		vy += wy[b] * sy;
+	}
+	const double *const x0 = u.xRow(c.j), *const x1 = u.xRow(c.j + 1), *const y0 = u.yRow(c.j), *const y1 = u.yRow(c.j + 1);
+	const uint32_t i = c.i;
+	vx = std::clamp(vx, std::min({x0[i], x0[i + 1], x1[i], x1[i + 1]}), std::max({x0[i], x0[i + 1], x1[i], x1[i + 1]}));
+	vy = std::clamp(vy, std::min({y0[i], y0[i + 1], y1[i], y1[i + 1]}), std::max({y0[i], y0[i + 1], y1[i], y1[i + 1]}));
+	return vec2d(vx, vy);
+}
+
+/**
+ * Computes the velocity advected by the semi-Lagrangian scheme on the points x0 <= x < x1 of a row (@see StencilKernels::semiLagrangianRow)
+ */
+template <bool Masked>
+void semiLagrangian(const Vec2dGrid &u, const BitGrid &solid, const uint64_t *const mask, Vec2dGrid &ww, const uint32_t y,
+	const uint32_t x0, const uint32_t x1, const double dt, const double dx, const double dy, const bool cubic)
+{
+	// number of bisections of a path leading into an obstacle
+	constexpr uint32_t Bisections = 8;
+	const double sx = dt / dx, sy = dt / dy;
+	const double maxX = u.w - 1, maxY = u.h - 1;
+	const double *const ux = u.xRow(y), *const uy = u.yRow(y);
+	double *const wwx = ww.xRow(y), *const wwy = ww.yRow(y);
+	for (uint32_t i = x0; i < x1; i++)
+	{
+		if (!isWritten<Masked>(mask, i))
+			continue;
+		// the cell containing the point displaced by (ex, ey) from (i, y) and clamped to the grid
+		auto cellAt = [&](const double ex, const double ey)
+		{
+			return GridCell(std::clamp(i + ex, 0., maxX), std::clamp(y + ey, 0., maxY), u.w, u.h);
+		};
+		// the path back along the velocity at its midpoint (the obstacles are no-slip, so the velocity in them is zero)
+		const vec2d mid = sampleLinear(u, cellAt(-.5 * sx * ux[i], -.5 * sy * uy[i]));
+		const double tx = -sx * mid.x, ty = -sy * mid.y;
+		GridCell c = cellAt(tx, ty);
+		if (c.readsSolid(solid))
+		{
+			// the interpolation at (i, y) itself only reads the independent point there, so shorten the path to the last point found outside the obstacles
+			double lo = 0, hi = 1;
+			for (uint32_t k = 0; k < Bisections; k++)
+			{
+				const double t = (lo + hi) / 2;
+				(cellAt(t * tx, t * ty).readsSolid(solid) ? hi : lo) = t;
+			}
+			c = cellAt(lo * tx, lo * ty);
+		}
+		const vec2d v = cubic ? sampleCubic(u, solid, c) : sampleLinear(u, c);
+		wwx[i] = v.x;
+		wwy[i] = v.y;
+	}
+}
+
+void StencilKernels::semiLagrangianRow(const Vec2dGrid &u, const BitGrid &solid, const BitGrid &indep, Vec2dGrid &ww, const uint32_t y,
+	const double dt, const double dx, const double dy, const bool cubic)
+{
+	semiLagrangian<true>(u, solid, indep.row(y), ww, y, 1, u.w - 1, dt, dx, dy, cubic);
+}
+
+void StencilKernels::semiLagrangianSpan(const Vec2dGrid &u, const BitGrid &solid, Vec2dGrid &ww, const GridRun &run,
+	const double dt, const double dx, const double dy, const bool cubic)
+{
+	semiLagrangian<false>(u, solid, nullptr, ww, run.y, run.x0, run.x1, dt, dx, dy, cubic);
+}
+
+/**
+ * Performs a half-sweep of the implicit viscous step on the points x0 <= x < x1 of a row given pointers to the rows
+ * (@see StencilKernels::viscousRelaxRow)
+ */
+template <bool Masked>
+BRANDY0_TARGET_CLONES
+double viscousRelax(double *const wwx, const double *const __restrict wwxDown, const double *const __restrict wwxUp,
+	double *const wwy, const double *const __restrict wwyDown, const double *const __restrict wwyUp,
+	const double *const __restrict rhsx, const double *const __restrict rhsy, const uint64_t *const __restrict mask,
+	const uint32_t x0, const uint32_t x1, const double dt, const double nu, const double dx, const double dy, const double dl1)
+{
+	const double a = dt * nu / (dx * dx);
+	const double b = dt * nu / (dy * dy);
+	const double invDiag = 1 / (1 + 2 * a + 2 * b);
+	double acc = dl1;
+	for (uint32_t i = x0; i < x1; i += 2)
+	{
+		const double nx = (rhsx[i] + a * (wwx[i - 1] + wwx[i + 1]) + b * (wwxDown[i] + wwxUp[i])) * invDiag;
+		const double ny = (rhsy[i] + a * (wwy[i - 1] + wwy[i + 1]) + b * (wwyDown[i] + wwyUp[i])) * invDiag;
+		const bool in = isWritten<Masked>(mask, i);
+		acc += in ? std::abs(nx - wwx[i]) + std::abs(ny - wwy[i]) : 0;
+		wwx[i] = in ? nx : wwx[i];
+		wwy[i] = in ? ny : wwy[i];
+	}
+	return acc;
+}
+
+double StencilKernels::viscousRelaxRow(Vec2dGrid &ww, const Vec2dGrid &rhs, const BitGrid &indep, const uint32_t y, const uint32_t x0,
+	const double dt, const double nu, const double dx, const double dy, const double dl1)
+{
+	return viscousRelax<true>(ww.xRow(y), ww.xRow(y - 1), ww.xRow(y + 1), ww.yRow(y), ww.yRow(y - 1), ww.yRow(y + 1),
+		rhs.xRow(y), rhs.yRow(y), indep.row(y), x0, ww.w - 1, dt, nu, dx, dy, dl1);
+}
+
+double StencilKernels::viscousRelaxSpan(Vec2dGrid &ww, const Vec2dGrid &rhs, const GridRun &run, const uint32_t parity,
+	const double dt, const double nu, const double dx, const double dy, const double dl1)
+{
+	const uint32_t y = run.y;
+	// the first point of the span with the parity of the half-sweep
+	const uint32_t x0 = run.x0 + ((run.x0 ^ parity) & 1);
+	return viscousRelax<false>(ww.xRow(y), ww.xRow(y - 1), ww.xRow(y + 1), ww.yRow(y), ww.yRow(y - 1), ww.yRow(y + 1),
+		rhs.xRow(y), rhs.yRow(y), nullptr, x0, run.x1, dt, nu, dx, dy, dl1);
+}
+
+/**
+ * Computes the RHS of the Poisson equation for pressure on the points x0 <= x < x1 of a row given restrict-qualified pointers to the rows
+ * (@see StencilKernels::divergenceRow)
+ */
+template <bool Masked>
+BRANDY0_TARGET_CLONES
+bool divergence(const double *const __restrict wwx, const double *const __restrict wwyDown, const double *const __restrict wwyUp,
+	const uint64_t *const __restrict mask, double *const __restrict field,
+	const uint32_t x0, const uint32_t x1, const double rho, const double dt, const double dx, const double dy, const double crashLimit)
+{
+	const double coef = rho / dt;
+	const double r2dx = 1 / (2 * dx);
+	const double r2dy = 1 / (2 * dy);
+	uint8_t crashed = 0;
+	for (uint32_t i = x0; i < x1; i++)
+	{
+		const double f = coef * ((wwx[i + 1] - wwx[i - 1]) * r2dx + (wwyUp[i] - wwyDown[i]) * r2dy);
+		const uint8_t in = isWritten<Masked>(mask, i);
+		field[i] = in ? f : field[i];
+		crashed |= in & ((f > crashLimit) | (f < -crashLimit));
+	}
+	return crashed;
+}
+
+bool StencilKernels::divergenceRow(const Vec2dGrid &ww, const BitGrid &indep, Grid<double> &field, const uint32_t y,
+	const double rho, const double dt, const double dx, const double dy, const double crashLimit)
+{
+	return divergence<true>(ww.xRow(y), ww.yRow(y - 1), ww.yRow(y + 1), indep.row(y), &field(0, y),
+		1, ww.w - 1, rho, dt, dx, dy, crashLimit);
+}
+
+bool StencilKernels::divergenceSpan(const Vec2dGrid &ww, Grid<double> &field, const GridRun &run,
+	const double rho, const double dt, const double dx, const double dy, const double crashLimit)
+{
+	const uint32_t y = run.y;
+	return divergence<false>(ww.xRow(y), ww.yRow(y - 1), ww.yRow(y + 1), nullptr, &field(0, y),
+		run.x0, run.x1, rho, dt, dx, dy, crashLimit);
+}
+
+/**
+ * Computes the velocity on the points x0 <= x < x1 of a row given restrict-qualified pointers to the rows (@see StencilKernels::projectRow)
+ */
+template <bool Masked>
+BRANDY0_TARGET_CLONES
+bool project(const double *const __restrict wwx, const double *const __restrict wwy,
+	const double *const __restrict p, const double *const __restrict pDown, const double *const __restrict pUp,
+	const uint64_t *const __restrict mask, double *const __restrict ux, double *const __restrict uy,
+	const uint32_t x0, const uint32_t x1, const double rho, const double dt, const double dx, const double dy)
+{
+	const double rx = dt / rho / (2 * dx);
+	const double ry = dt / rho / (2 * dy);
+	uint8_t nan = 0;
+	for (uint32_t i = x0; i < x1; i++)
+	{
+		const double nx = wwx[i] - rx * (p[i + 1] - p[i - 1]);
+		const double ny = wwy[i] - ry * (pUp[i] - pDown[i]);
+		const uint8_t in = isWritten<Masked>(mask, i);
+		ux[i] = in ? nx : ux[i];
+		uy[i] = in ? ny : uy[i];
+		// NaN is the only value not equal to itself
+		nan |= in & ((nx != nx) | (ny != ny));
+	}
+	return nan;
+}
+
+bool StencilKernels::projectRow(const Vec2dGrid &ww, const Grid<double> &p, const BitGrid &indep, Vec2dGrid &u, const uint32_t y,
+	const double rho, const double dt, const double dx, const double dy)
+{
+	return project<true>(ww.xRow(y), ww.yRow(y), &p(0, y), &p(0, y - 1), &p(0, y + 1), indep.row(y),
+		u.xRow(y), u.yRow(y), 1, u.w - 1, rho, dt, dx, dy);
+}
+
+bool StencilKernels::projectSpan(const Vec2dGrid &ww, const Grid<double> &p, Vec2dGrid &u, const GridRun &run,
+	const double rho, const double dt, const double dx, const double dy)
+{
+	const uint32_t y = run.y;
+	return project<false>(ww.xRow(y), ww.yRow(y), &p(0, y), &p(0, y - 1), &p(0, y + 1), nullptr,
+		u.xRow(y), u.yRow(y), run.x0, run.x1, rho, dt, dx, dy);
+}
+
+/**
+ * Performs a half-sweep of the relaxation on the points x0 <= x < x1 of a row given restrict-qualified pointers to the rows
+ * (@see StencilKernels::relaxRow)
+ * @tparam T type of the values of the fields (the change of the pressure is also accumulated in it)
+ */
+template <typename T>
+BRANDY0_TARGET_CLONES
+double relax(T *const p, const T *const __restrict pDown, const T *const __restrict pUp,
+	const T *const __restrict field, const uint8_t *const __restrict mask, const T *const __restrict invDiag,
+	const uint32_t x0, const uint32_t x1, const double dx, const double dy, const double dl1)
+{
+	const T wx = dy * dy;
+	const T wy = dx * dx;
+	const T fieldCoef = (dx * dx) * (dy * dy);
+	T acc = dl1;
+	for (uint32_t i = x0; i < x1; i += 2)
+	{
+		const uint8_t m = mask[i];
+		// the neighbors outside the stencil are selected out (not multiplied by a zero weight), so that their values don't matter
+		T sm = 0;
+		sm += (m & RelaxRight) ? wx * p[i + 1] : 0;
+		sm += (m & RelaxLeft) ? wx * p[i - 1] : 0;
+		sm += (m & RelaxUp) ? wy * pUp[i] : 0;
+		sm += (m & RelaxDown) ? wy * pDown[i] : 0;
+		const T newval = (sm - fieldCoef * field[i]) * invDiag[i] * T(1.5) - T(.5) * p[i];
+		const bool unknown = m & RelaxUnknown;
+		acc += unknown ? std::abs(p[i] - newval) : 0;
+		p[i] = unknown ? newval : p[i];
+	}
+	return acc;
+}
+
+/**
+ * Performs a half-sweep of the relaxation on the points x0 <= x < x1 of a row, all of which are interior unknowns,
+ * given restrict-qualified pointers to the rows (@see StencilKernels::relaxInteriorSpan)
+ * @tparam T type of the values of the fields
+ */
+template <typename T>
+BRANDY0_TARGET_CLONES
+double relaxInterior(T *const p, const T *const __restrict pDown, const T *const __restrict pUp,
+	const T *const __restrict field, const uint32_t x0, const uint32_t x1, const double dx, const double dy, const double dl1)
+{
+	const T wx = dy * dy;
+	const T wy = dx * dx;
+	const T fieldCoef = (dx * dx) * (dy * dy);
+	// the same expression as the coefficient of an unknown with all four neighbors in the stencil in SimulatorClassic::buildRelaxationStencil
+	const T invDiag = 1 / (2 * dx * dx + 2 * dy * dy);
+	T acc = dl1;
+	for (uint32_t i = x0; i < x1; i += 2)
+	{
+		// summed in the same order as in relax, so that the results are the same
+		const T sm = wx * p[i + 1] + wx * p[i - 1] + wy * pUp[i] + wy * pDown[i];
+		const T newval = (sm - fieldCoef * field[i]) * invDiag * T(1.5) - T(.5) * p[i];
+		acc += std::abs(p[i] - newval);
+		p[i] = newval;
+	}
+	return acc;
+}
+
+/**
+ * Computes the squared norms of the residual and of the RHS on the points x0 <= x < x1 of a row given restrict-qualified pointers to the rows
+ * (@see StencilKernels::residualRow)
+ * @tparam Store true iff the negated residual should be stored into correctionRhs (0 at the points that aren't unknowns)
+ */
+template <bool Store>
+BRANDY0_TARGET_CLONES
+double residual(const double *const __restrict p, const double *const __restrict pDown, const double *const __restrict pUp,
+	const double *const __restrict field, const uint8_t *const __restrict mask, float *const __restrict correctionRhs,
+	const uint32_t x0, const uint32_t x1, const double dx, const double dy, double &fieldSq)
+{
+	const double wx = dy * dy;
+	const double wy = dx * dx;
+	const double rFieldCoef = 1 / ((dx * dx) * (dy * dy));
+	double rSq = 0, fSq = 0;
+	for (uint32_t i = x0; i < x1; i++)
+	{
+		const uint8_t m = mask[i];
+		// the diagonal coefficient is the sum of the weights of the neighbors in the stencil (@see SimulatorClassic::buildRelaxationStencil)
+		double sm = 0, coef = 0;
+		sm += (m & RelaxRight) ? wx * p[i + 1] : 0;
+		sm += (m & RelaxLeft) ? wx * p[i - 1] : 0;
+		sm += (m & RelaxUp) ? wy * pUp[i] : 0;
+		sm += (m & RelaxDown) ? wy * pDown[i] : 0;
+		coef += (m & RelaxRight) ? wx : 0;
+		coef += (m & RelaxLeft) ? wx : 0;
+		coef += (m & RelaxUp) ? wy : 0;
+		coef += (m & RelaxDown) ? wy : 0;
+		const double r = (sm - coef * p[i]) * rFieldCoef - field[i];
+		const bool unknown = m & RelaxUnknown;
+		rSq += unknown ? r * r : 0;
+		fSq += unknown ? field[i] * field[i] : 0;
+		if constexpr (Store)
+			correctionRhs[i] = unknown ? float(-r) : 0;
+	}
+	fieldSq += fSq;
+	return rSq;
+}
+
+double StencilKernels::relaxRow(Grid<double> &p, const Grid<double> &field, const Grid<uint8_t> &mask, const Grid<double> &invDiag,
+	const uint32_t y, const uint32_t x0, const double dx, const double dy, const double dl1)
+{
+	return relax(&p(0, y), &p(0, y - 1), &p(0, y + 1), &field(0, y), &mask(0, y), &invDiag(0, y), x0, p.w - 1, dx, dy, dl1);
+}
+
+double StencilKernels::relaxRow(Grid<float> &p, const Grid<float> &field, const Grid<uint8_t> &mask, const Grid<float> &invDiag,
+	const uint32_t y, const uint32_t x0, const double dx, const double dy, const double dl1)
+{
+	return relax(&p(0, y), &p(0, y - 1), &p(0, y + 1), &field(0, y), &mask(0, y), &invDiag(0, y), x0, p.w - 1, dx, dy, dl1);
+}
+
+double StencilKernels::relaxSpan(Grid<double> &p, const Grid<double> &field, const Grid<uint8_t> &mask, const Grid<double> &invDiag,
+	const GridRun &run, const uint32_t parity, const double dx, const double dy, const double dl1)
+{
+	const uint32_t y = run.y;
+	// the first point of the span with the parity of the half-sweep
+	const uint32_t x0 = run.x0 + ((run.x0 ^ parity) & 1);
+	return relax(&p(0, y), &p(0, y - 1), &p(0, y + 1), &field(0, y), &mask(0, y), &invDiag(0, y), x0, run.x1, dx, dy, dl1);
+}
+
+double StencilKernels::relaxSpan(Grid<float> &p, const Grid<float> &field, const Grid<uint8_t> &mask, const Grid<float> &invDiag,
+	const GridRun &run, const uint32_t parity, const double dx, const double dy, const double dl1)
+{
+	const uint32_t y = run.y;
+	const uint32_t x0 = run.x0 + ((run.x0 ^ parity) & 1);
+	return relax(&p(0, y), &p(0, y - 1), &p(0, y + 1), &field(0, y), &mask(0, y), &invDiag(0, y), x0, run.x1, dx, dy, dl1);
+}
+
+double StencilKernels::relaxInteriorSpan(Grid<double> &p, const Grid<double> &field, const GridRun &run, const uint32_t parity,
+	const double dx, const double dy, const double dl1)
+{
+	const uint32_t y = run.y;
+	const uint32_t x0 = run.x0 + ((run.x0 ^ parity) & 1);
+	return relaxInterior(&p(0, y), &p(0, y - 1), &p(0, y + 1), &field(0, y), x0, run.x1, dx, dy, dl1);
+}
+
+double StencilKernels::relaxInteriorSpan(Grid<float> &p, const Grid<float> &field, const GridRun &run, const uint32_t parity,
+	const double dx, const double dy, const double dl1)
+{
+	const uint32_t y = run.y;
+	const uint32_t x0 = run.x0 + ((run.x0 ^ parity) & 1);
+	return relaxInterior(&p(0, y), &p(0, y - 1), &p(0, y + 1), &field(0, y), x0, run.x1, dx, dy, dl1);
+}
+
+double StencilKernels::residualRow(const Grid<double> &p, const Grid<double> &field, const Grid<uint8_t> &mask,
+	const uint32_t y, const double dx, const double dy, double &fieldSq)
+{
+	return residual<false>(&p(0, y), &p(0, y - 1), &p(0, y + 1), &field(0, y), &mask(0, y), nullptr, 1, p.w - 1, dx, dy, fieldSq);
+}
+
+double StencilKernels::residualRow(const Grid<double> &p, const Grid<double> &field, const Grid<uint8_t> &mask,
+	const uint32_t y, const double dx, const double dy, double &fieldSq, Grid<float> &correctionRhs)
+{
+	return residual<true>(&p(0, y), &p(0, y - 1), &p(0, y + 1), &field(0, y), &mask(0, y), &correctionRhs(0, y), 1, p.w - 1, dx, dy, fieldSq);
+}
+
+}
@@ -0,0 +1,313 @@
+/**
+ * stencil-kernels.hpp
+ *
+ * Author: Viktor Fukala
+ * Created on 2026/10/17
+ */
+#ifndef STENCIL_KERNELS_HPP
+#define STENCIL_KERNELS_HPP
+
+#include <array>
+#include <cstdint>
+
+#if defined(__x86_64__)
+#include <pmmintrin.h>
+#endif
+
+#include "bit-grid.hpp"
+#include "grid.hpp"
+#include "str.hpp"
+#include "vec2d-grid.hpp"
+
+/**
+ * Attribute making the compiler emit AVX-512, AVX2, and baseline versions of a function,
+ * the best of which is selected at runtime according to the CPU (only available with GCC on x86-64)
+ */
+#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__)
+#define BRANDY0_TARGET_CLONES __attribute__((target_clones("avx512f", "avx2", "default")))
+#else
+#define BRANDY0_TARGET_CLONES
+#endif
+
+namespace brandy0
+{
+
+/**
+ * Guard making the floating-point arithmetic of the current thread treat subnormal numbers as zero while it exists (only on x86-64).
+ * The single-precision relaxation of a correction of the pressure needs it: the correction decays to subnormal values in the calm regions,
+ * the arithmetic on which is many times slower
+ */
+class SubnormalFlushGuard
+{
+private:
+#if defined(__x86_64__)
+	/// Control and status register of the SSE unit before the guard was constructed
+	uint32_t savedCsr;
+	/// True iff the flushing was enabled by this guard
+	bool enabled;
+#endif
+public:
+	/**
+	 * Constructs a SubnormalFlushGuard object
+	 * @param enable false iff the guard should do nothing
+	 */
+	explicit SubnormalFlushGuard(const bool enable)
+	{
+#if defined(__x86_64__)
+		enabled = enable;
+		if (enabled)
+		{
+			savedCsr = _mm_getcsr();
+			_mm_setcsr(savedCsr | _MM_FLUSH_ZERO_ON | _MM_DENORMALS_ZERO_ON);
+		}
+#else
+		(void) enable;
+#endif
+	}
+	~SubnormalFlushGuard()
+	{
+#if defined(__x86_64__)
+		if (enabled)
+			_mm_setcsr(savedCsr);
+#endif
+	}
+	SubnormalFlushGuard(const SubnormalFlushGuard &) = delete;
+	SubnormalFlushGuard &operator=(const SubnormalFlushGuard &) = delete;
+};
+
+/**
+ * Represents the way the stencil passes of SimulatorClassic::iter iterate over the points of a row
+ */
+enum CellIterationMode
+{
+	/// Spans if the independent points form long enough runs, otherwise whole rows (@see SimulatorClassic::MinAverageRunLength)
+	CellIterationAutomatic,
+	/// Whole inner rows with the non-independent points masked out (@see StencilKernels::advectDiffuseRow etc.)
+	CellIterationRows,
+	/// Only the runs of independent points (@see StencilKernels::advectDiffuseSpan etc.)
+	CellIterationSpans
+};
+
+/// Names of all the cell iteration modes (as shown to the user) indexed by the CellIterationMode values
+const std::array<str, 3> CellIterationModeNames{
+	"automatic", "whole rows", "fluid spans"
+};
+
+/**
+ * Bits of the per-point masks describing the stencil of the pressure relaxation (@see StencilKernels::relaxRow)
+ */
+enum RelaxationStencilBit : uint8_t
+{
+	/// The pressure at the point is an unknown of the Poisson equation (the point is independent and its pressure isn't set by a Dirichlet b.c.)
+	RelaxUnknown = 1,
+	/// The neighbor at x + 1 takes part in the stencil
+	RelaxRight = 2,
+	/// The neighbor at x - 1 takes part in the stencil
+	RelaxLeft = 4,
+	/// The neighbor at y + 1 takes part in the stencil
+	RelaxUp = 8,
+	/// The neighbor at y - 1 takes part in the stencil
+	RelaxDown = 16,
+	/// All the bits: the point is an unknown whose four neighbors all take part in the stencil (@see StencilKernels::relaxInteriorSpan)
+	RelaxInterior = 31
+};
+
+/**
+ * Class with static methods computing the stencil passes of SimulatorClassic::iter one grid row at a time.
+ *
+ * The kernels are branchless (the upwind choice and the mask of independent points are expressed as selects
+ * between values computed for every point), so that the compiler can vectorize them over the component planes of the vector grids,
+ * and they are compiled for several instruction sets with a runtime dispatch (@see BRANDY0_TARGET_CLONES).
+ * The divisions by the spacial steps are replaced by multiplications by their precomputed reciprocals
+ * (the divisions would otherwise bound the throughput of both the scalar and the vector code),
+ * so the results agree with the point-by-point evaluation of the same formulas up to rounding errors.
+ *
+ * Each *Row kernel computes the values at the inner points (0 < x < w - 1) of an inner row (0 < y < h - 1)
+ * and writes them only at the independent ones.
+ * Each *Span kernel computes the values only at the points of a run of independent points of an inner row (@see DomainGeometry::indepRuns),
+ * which skips the obstacles and doesn't have to read the mask (the results are the same as of the *Row kernel at those points).
+ */
+class StencilKernels
+{
+public:
+	/**
+	 * Computes the intermediate velocity w = u + dt * (nu * laplacian(u) - (u . grad) u) with upwind differencing of the convective term
+	 * @param u velocity field
+	 * @param indep grid of independent points (@see Simulator::indep)
+	 * @param ww intermediate velocity field (output)
+	 * @param y index of the row to compute
+	 * @param dt time step
+	 * @param nu kinematic viscosity
+	 * @param dx spacial step along the x axis
+	 * @param dy spacial step along the y axis
+	 */
+	static void advectDiffuseRow(const Vec2dGrid &u, const BitGrid &indep, Vec2dGrid &ww, uint32_t y,
+		double dt, double nu, double dx, double dy);
+	/**
+	 * Computes the intermediate velocity on a run of independent points (@see advectDiffuseRow)
+	 */
+	static void advectDiffuseSpan(const Vec2dGrid &u, Vec2dGrid &ww, const GridRun &run,
+		double dt, double nu, double dx, double dy);
+	/**
+	 * Computes the velocity advected by the semi-Lagrangian scheme, i.e. u interpolated at the point from which the fluid arrives
+	 * in the time step (traced back along the velocity at the midpoint of the path). The path is clamped to the grid and shortened
+	 * so that the interpolation doesn't read the velocity inside an obstacle.
+	 * Unlike the other kernels, it reads the field at data-dependent points, so it is neither branchless nor vectorized
+	 * @param u velocity field
+	 * @param solid grid of solid points (@see Simulator::solid)
+	 * @param indep grid of independent points (@see Simulator::indep)
+	 * @param ww advected velocity field (output)
+	 * @param y index of the row to compute
+	 * @param dt time step
+	 * @param dx spacial step along the x axis
+	 * @param dy spacial step along the y axis
+	 * @param cubic true iff the interpolation should be bicubic (limited to the range of the values of the bilinear one),
+	 * otherwise it is bilinear (the bicubic one falls back to it next to the obstacles)
+	 */
+	static void semiLagrangianRow(const Vec2dGrid &u, const BitGrid &solid, const BitGrid &indep, Vec2dGrid &ww, uint32_t y,
+		double dt, double dx, double dy, bool cubic);
+	/**
+	 * Computes the velocity advected by the semi-Lagrangian scheme on a run of independent points (@see semiLagrangianRow)
+	 */
+	static void semiLagrangianSpan(const Vec2dGrid &u, const BitGrid &solid, Vec2dGrid &ww, const GridRun &run,
+		double dt, double dx, double dy, bool cubic);
+	/**
+	 * Performs one half-sweep of the red-black Gauss-Seidel iteration of the implicit viscous step w - dt * nu * laplacian(w) = rhs on a row,
+	 * i.e. updates w at every other point of the row starting at x0 (the values at the points that aren't independent are the b.c.)
+	 * @param ww velocity field (updated in place)
+	 * @param rhs RHS of the equation (the advected velocity)
+	 * @param indep grid of independent points (@see Simulator::indep)
+	 * @param y index of the row to compute
+	 * @param x0 x index of the first point to update (1 or 2)
+	 * @param dt time step
+	 * @param nu kinematic viscosity
+	 * @param dx spacial step along the x axis
+	 * @param dy spacial step along the y axis
+	 * @param dl1 L1 norm of the change of the velocity accumulated so far
+	 * @return dl1 plus the L1 norm of the change of the velocity (both components) on the updated points of the row
+	 */
+	static double viscousRelaxRow(Vec2dGrid &ww, const Vec2dGrid &rhs, const BitGrid &indep, uint32_t y, uint32_t x0,
+		double dt, double nu, double dx, double dy, double dl1);
+	/**
+	 * Performs one half-sweep of the implicit viscous step on a run of independent points (@see viscousRelaxRow),
+	 * i.e. updates the points of the run whose x index has the same parity as the parameter parity
+	 */
+	static double viscousRelaxSpan(Vec2dGrid &ww, const Vec2dGrid &rhs, const GridRun &run, uint32_t parity,
+		double dt, double nu, double dx, double dy, double dl1);
+	/**
+	 * Computes the RHS of the Poisson equation for pressure (rho / dt times the central-difference divergence of the intermediate velocity)
+	 * @param ww intermediate velocity field
+	 * @param indep grid of independent points (@see Simulator::indep)
+	 * @param field RHS (output)
+	 * @param y index of the row to compute
+	 * @param rho density
+	 * @param dt time step
+	 * @param dx spacial step along the x axis
+	 * @param dy spacial step along the y axis
+	 * @param crashLimit upper bound on the absolute value of the RHS
+	 * @return true iff the absolute value of the RHS exceeds crashLimit at some independent point of the row
+	 */
+	static bool divergenceRow(const Vec2dGrid &ww, const BitGrid &indep, Grid<double> &field, uint32_t y,
+		double rho, double dt, double dx, double dy, double crashLimit);
+	/**
+	 * Computes the RHS of the Poisson equation for pressure on a run of independent points (@see divergenceRow)
+	 */
+	static bool divergenceSpan(const Vec2dGrid &ww, Grid<double> &field, const GridRun &run,
+		double rho, double dt, double dx, double dy, double crashLimit);
+	/**
+	 * Computes the velocity by subtracting the pressure gradient (multiplied by dt / rho) from the intermediate velocity
+	 * @param ww intermediate velocity field
+	 * @param p pressure field
+	 * @param indep grid of independent points (@see Simulator::indep)
+	 * @param u velocity field (output)
+	 * @param y index of the row to compute
+	 * @param rho density
+	 * @param dt time step
+	 * @param dx spacial step along the x axis
+	 * @param dy spacial step along the y axis
+	 * @return true iff the velocity is NaN at some independent point of the row
+	 */
+	static bool projectRow(const Vec2dGrid &ww, const Grid<double> &p, const BitGrid &indep, Vec2dGrid &u, uint32_t y,
+		double rho, double dt, double dx, double dy);
+	/**
+	 * Computes the velocity on a run of independent points (@see projectRow)
+	 */
+	static bool projectSpan(const Vec2dGrid &ww, const Grid<double> &p, Vec2dGrid &u, const GridRun &run,
+		double rho, double dt, double dx, double dy);
+	/**
+	 * Performs one half-sweep of the red-black over-relaxation (with the factor 1.5) of the Poisson equation for pressure on a row,
+	 * i.e. updates the unknowns at every other point of the row starting at x0 (the change of the pressure is accumulated in the precision of the fields)
+	 * @param p pressure field (updated in place)
+	 * @param field RHS of the Poisson equation
+	 * @param mask per-point masks of RelaxationStencilBit values
+	 * @param invDiag per-point reciprocals of the diagonal coefficients of the equation (the sums of the weights of the neighbors in the stencil)
+	 * @param y index of the row to compute
+	 * @param x0 x index of the first point to update (1 or 2)
+	 * @param dx spacial step along the x axis
+	 * @param dy spacial step along the y axis
+	 * @param dl1 L1 norm of the change of the pressure accumulated so far
+	 * @return dl1 plus the L1 norm of the change of the pressure on the updated points of the row
+	 */
+	static double relaxRow(Grid<double> &p, const Grid<double> &field, const Grid<uint8_t> &mask, const Grid<double> &invDiag,
+		uint32_t y, uint32_t x0, double dx, double dy, double dl1);
+	/**
+	 * Performs one half-sweep of the relaxation on a row in single precision (@see relaxRow)
+	 */
+	static double relaxRow(Grid<float> &p, const Grid<float> &field, const Grid<uint8_t> &mask, const Grid<float> &invDiag,
+		uint32_t y, uint32_t x0, double dx, double dy, double dl1);
+	/**
+	 * Performs one half-sweep of the relaxation on a run of points of an inner row (@see relaxRow),
+	 * i.e. updates the unknowns at the points of the run whose x index has the same parity as the parameter parity
+	 */
+	static double relaxSpan(Grid<double> &p, const Grid<double> &field, const Grid<uint8_t> &mask, const Grid<double> &invDiag,
+		const GridRun &run, uint32_t parity, double dx, double dy, double dl1);
+	/**
+	 * Performs one half-sweep of the relaxation on a run of points in single precision (@see relaxSpan)
+	 */
+	static double relaxSpan(Grid<float> &p, const Grid<float> &field, const Grid<uint8_t> &mask, const Grid<float> &invDiag,
+		const GridRun &run, uint32_t parity, double dx, double dy, double dl1);
+	/**
+	 * Performs one half-sweep of the relaxation on a run of interior unknowns (points with the mask RelaxInterior),
+	 * which needs neither the masks nor the diagonal coefficients and has no selects.
+	 * The results are the same as of relaxSpan on such a run
+	 * @param p pressure field (updated in place)
+	 * @param field RHS of the Poisson equation
+	 * @param run run of the points
+	 * @param parity the points whose x index has the same parity as this parameter are updated
+	 * @param dx spacial step along the x axis
+	 * @param dy spacial step along the y axis
+	 * @param dl1 L1 norm of the change of the pressure accumulated so far
+	 * @return dl1 plus the L1 norm of the change of the pressure on the updated points of the run
+	 */
+	static double relaxInteriorSpan(Grid<double> &p, const Grid<double> &field, const GridRun &run, uint32_t parity,
+		double dx, double dy, double dl1);
+	/**
+	 * Performs one half-sweep of the relaxation on a run of interior unknowns in single precision (@see relaxInteriorSpan)
+	 */
+	static double relaxInteriorSpan(Grid<float> &p, const Grid<float> &field, const GridRun &run, uint32_t parity,
+		double dx, double dy, double dl1);
+	/**
+	 * Computes the residual (the laplacian of the pressure minus the RHS) of the Poisson equation for pressure at the unknowns of a row
+	 * @param p pressure field
+	 * @param field RHS of the Poisson equation
+	 * @param mask per-point masks of RelaxationStencilBit values
+	 * @param y index of the row to compute
+	 * @param dx spacial step along the x axis
+	 * @param dy spacial step along the y axis
+	 * @param fieldSq squared L2 norm of the RHS at the unknowns accumulated so far (the norm on the row is added)
+	 * @return squared L2 norm of the residual at the unknowns of the row
+	 */
+	static double residualRow(const Grid<double> &p, const Grid<double> &field, const Grid<uint8_t> &mask,
+		uint32_t y, double dx, double dy, double &fieldSq);
+	/**
+	 * Computes the residual at the unknowns of a row (@see residualRow) and stores it negated in single precision,
+	 * i.e. as the RHS of the equation for the correction of the pressure
+	 * @param correctionRhs RHS of the equation for the correction (output, 0 at the points of the row that aren't unknowns)
+	 */
+	static double residualRow(const Grid<double> &p, const Grid<double> &field, const Grid<uint8_t> &mask,
+		uint32_t y, double dx, double dy, double &fieldSq, Grid<float> &correctionRhs);
+};
+
+}
+
+#endif // STENCIL_KERNELS_HPP
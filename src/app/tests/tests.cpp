@@ -7,9 +7,22 @@
 #include "tests.hpp"
 
 #include <cassert>
+#include <cmath>
+#include <functional>
+#include <utility>
 
+#include "connected-components.hpp"
 #include "conv-utils.hpp"
+#include "domain-geometry.hpp"
 #include "obstacle-shape.hpp"
+#include "pressure-solver-cholesky.hpp"
+#include "pressure-solver-conjugate-gradient.hpp"
+#include "pressure-solver-multigrid.hpp"
+#include "pressure-solver-spectral.hpp"
+#include "sim-frame.hpp"
+#include "simulator-classic.hpp"
+#include "stencil-kernels.hpp"
+#include "thread-pool.hpp"
 
 namespace brandy0
 {
@@ -47,6 +60,11 @@ void Tests::testConv()
 	assert(ConvUtils::timeToString(.023) == "0.02300");
 	assert(ConvUtils::timeToString(34) == "34.00");
 	assert(ConvUtils::timeToString(2.93333) == "2.933");
+
+	assert(ConvUtils::bytesToString(512) == "512 B");
+	assert(ConvUtils::bytesToString(1536) == "1.5 KiB");
+	assert(ConvUtils::bytesToString(3 << 20) == "3.0 MiB");
+	assert(ConvUtils::bytesToString(uint64_t(5) << 40) == "5120.0 GiB");
 }
 
 void Tests::testObstacleShapes()
@@ -68,12 +86,846 @@ void Tests::testObstacleShapes()
 	assert(!singleton.inside(vec2d(1, 0)));
 	assert(!singleton.inside(vec2d(-1, -1)));
 	assert(!singleton.inside(vec2d(-3.555e2, 7)));
+
+	// the rasterization must agree with the point-by-point test on every grid point (including those on the boundaries)
+	const vec<ObstaclePolygon> polygons{
+		tria,
+		singleton,
+		ObstaclePolygon(false, vec<vec2d>{ vec2d(.25, .125), vec2d(.25, .75), vec2d(.5, .75), vec2d(.5, .125) }),
+		ObstaclePolygon(false, vec<vec2d>{ vec2d(.5, 0), vec2d(.62, .9), vec2d(0, .3), vec2d(1, .3), vec2d(.38, .9) }),
+		ObstaclePolygon(false, vec<vec2d>{ vec2d(.3, .1), vec2d(.3000001, .9), vec2d(.7, .5), vec2d(.9, .95), vec2d(.1, .6) }),
+		ObstaclePolygon(false, vec<vec2d>{ vec2d(-.2, .4), vec2d(.6, -.3), vec2d(1.4, .5), vec2d(.5, 1.2) })
+	};
+	const vec<ObstacleEllipse> ellipses{
+		ObstacleEllipse(false, vec2d(.5, .5), .25, .125),
+		ObstacleEllipse(false, vec2d(.3, .7), .001, .3),
+		ObstacleEllipse(false, vec2d(.9, .1), .4, .6),
+		ObstacleEllipse(false, vec2d(.5, .5), 0, .2)
+	};
+	for (const uint32_t size : { 17u, 41u, 64u })
+	{
+		const uint32_t w = size, h = size * 3 / 4 + 1;
+		auto check = [w, h](const ObstacleShape &shape, const std::function<bool(vec2d)> &inside)
+		{
+			BitGrid grid(w, h);
+			grid.set_all(false);
+			shape.fill(grid);
+			for (uint32_t y = 0; y < h; y++)
+				for (uint32_t x = 0; x < w; x++)
+					assert(grid(x, y) == inside(vec2d(x / double(w - 1), y / double(h - 1))));
+		};
+		for (const ObstaclePolygon &polygon : polygons)
+			check(polygon, [&polygon](const vec2d p) { return polygon.inside(p); });
+		for (const ObstacleEllipse &ellipse : ellipses)
+			check(ellipse, [&ellipse](const vec2d p) { return ellipse.inside(p); });
+	}
+
+	// the cached masks of a stack must agree with rasterizing its shown shapes from scratch after any edits
+	// (including edits of a copy sharing the cache) and at any resolution
+	auto checkStack = [](const ObstacleShapeStack &stack, const uint32_t w, const uint32_t h)
+	{
+		BitGrid cached(w, h), expected(w, h);
+		cached.set_all(true);
+		stack.set(cached);
+		expected.set_all(false);
+		stack.fill(expected);
+		for (uint32_t y = 0; y < h; y++)
+			for (uint32_t x = 0; x < w; x++)
+				assert(cached(x, y) == expected(x, y));
+	};
+	ObstacleShapeStack stack;
+	checkStack(stack, 20, 15);
+	stack.push(make_shared<ObstacleRectangle>(false, vec2d(.1, .1), vec2d(.5, .6)));
+	stack.push(make_shared<ObstacleCircle>(false, vec2d(.4, .5), .3));
+	checkStack(stack, 20, 15);
+	checkStack(stack, 33, 9);
+	stack.push(make_shared<ObstacleEllipse>(false, vec2d(.7, .2), .2, .4));
+	checkStack(stack, 20, 15);
+	stack.undo();
+	stack.undo();
+	checkStack(stack, 20, 15);
+	stack.redo();
+	checkStack(stack, 20, 15);
+	checkStack(stack, 33, 9);
+	ObstacleShapeStack copy = stack;
+	copy.push(make_shared<ObstacleRectangle>(false, vec2d(.6, .6), vec2d(.9, .9)));
+	checkStack(copy, 20, 15);
+	checkStack(stack, 20, 15);
+	stack.redo();
+	checkStack(stack, 20, 15);
+	checkStack(copy, 20, 15);
+	stack.clear();
+	checkStack(stack, 20, 15);
+}
+
+void Tests::testPressureSolvers()
+{
+	// a 12x10 domain with Dirichlet edges and a Neumann obstacle in the middle
+	const uint32_t w = 12, h = 10;
+	const double dx = .3, dy = .2;
+	BitGrid indep(w, h), dirichlet(w, h);
+	Grid<double> field(w, h), p0(w, h);
+	for (uint32_t y = 0; y < h; y++)
+	{
+		for (uint32_t x = 0; x < w; x++)
+		{
+			const bool edge = x == 0 || y == 0 || x == w - 1 || y == h - 1;
+			const bool obstacle = x >= 4 && x <= 6 && y >= 3 && y <= 5;
+			indep(x, y) = !edge && !obstacle;
+			dirichlet(x, y) = edge;
+			field(x, y) = std::sin(double(x * 7 + y * 3));
+			p0(x, y) = edge ? double(x) / w : 0;
+		}
+	}
+
+	auto valid = [&indep, &dirichlet](const uint32_t x, const uint32_t y) { return indep(x, y) || dirichlet(x, y); };
+	auto check = [&](PressureSolver &solver)
+	{
+		Grid<double> p = p0;
+		assert(solver.solve(p, field, []{ return false; }) == PressureSolveResult::Converged);
+		for (uint32_t y = 1; y < h - 1; y++)
+		{
+			for (uint32_t x = 1; x < w - 1; x++)
+			{
+				if (!indep(x, y))
+					continue;
+				double lap = 0;
+				if (valid(x + 1, y))
+					lap += (p(x + 1, y) - p(x, y)) / (dx * dx);
+				if (valid(x - 1, y))
+					lap += (p(x - 1, y) - p(x, y)) / (dx * dx);
+				if (valid(x, y + 1))
+					lap += (p(x, y + 1) - p(x, y)) / (dy * dy);
+				if (valid(x, y - 1))
+					lap += (p(x, y - 1) - p(x, y)) / (dy * dy);
+				assert(std::abs(lap - field(x, y)) < 1e-6);
+			}
+		}
+		for (uint32_t x = 0; x < w; x++)
+			assert(p(x, 0) == p0(x, 0));
+	};
+
+	PressureSolverMultigrid multigrid(dx, dy, indep, dirichlet, 1e-12, 1000);
+	check(multigrid);
+	PressureSolverCholesky cholesky(dx, dy, indep, dirichlet);
+	check(cholesky);
+	assert(cholesky.getMemoryFootprint() > 0);
+	// the direct solvers count one iteration per solve
+	assert(cholesky.getIterationCount() == 1);
+	assert(PressureSolverSpectral::isSuitable(indep, dirichlet));
+	PressureSolverSpectral spectral(dx, dy, indep, dirichlet);
+	check(spectral);
+	for (const PcgPreconditionerType preconditioner : {PcgJacobi, PcgIncompleteCholesky, PcgMultigrid})
+	{
+		PressureSolverConjugateGradient pcg(dx, dy, indep, dirichlet, 1e-12, preconditioner, 1000);
+		check(pcg);
+	}
+
+	// an interrupted conjugate gradient solve continues from its kept state
+	PressureSolverConjugateGradient pcg(dx, dy, indep, dirichlet, 1e-12, PcgJacobi, 1000);
+	Grid<double> p = p0;
+	assert(pcg.solve(p, field, []{ return true; }) == PressureSolveResult::Interrupted);
+	const uint64_t interruptedIterations = pcg.getIterationCount();
+	check(pcg);
+	assert(interruptedIterations > 0 && pcg.getIterationCount() > interruptedIterations);
+
+	// the cap stops the iterative solvers before convergence (counting the iterations before an interruption as well)
+	PressureSolverMultigrid cappedMultigrid(dx, dy, indep, dirichlet, 0, 3);
+	p = p0;
+	assert(cappedMultigrid.solve(p, field, []{ return true; }) == PressureSolveResult::Interrupted);
+	assert(cappedMultigrid.solve(p, field, []{ return false; }) == PressureSolveResult::IterationCapReached);
+	assert(cappedMultigrid.getIterationCount() == 3);
+	PressureSolverConjugateGradient cappedPcg(dx, dy, indep, dirichlet, 1e-15, PcgJacobi, 20);
+	p = p0;
+	assert(cappedPcg.solve(p, field, []{ return true; }) == PressureSolveResult::Interrupted);
+	assert(cappedPcg.solve(p, field, []{ return false; }) == PressureSolveResult::IterationCapReached);
+	assert(cappedPcg.getIterationCount() == 20);
+
+	// with a zero RHS (zero field and zero Dirichlet pressure), the conjugate gradient solve converges from a nonzero guess instead of running to the cap
+	Grid<double> zeroField(w, h);
+	zeroField.set_all(0);
+	for (uint32_t y = 0; y < h; y++)
+		for (uint32_t x = 0; x < w; x++)
+			p(x, y) = indep(x, y) ? std::cos(double(x * 5 + y)) : 0;
+	PressureSolverConjugateGradient zeroRhsPcg(dx, dy, indep, dirichlet, 1e-12, PcgJacobi, 1000);
+	assert(zeroRhsPcg.solve(p, zeroField, []{ return false; }) == PressureSolveResult::Converged);
+	// reducing the initial residual by the tolerance takes far fewer iterations than its underflow to zero
+	assert(zeroRhsPcg.getIterationCount() < 100);
+	for (uint32_t i = 0; i < w * h; i++)
+		assert(std::abs(p.data[i]) < 1e-9);
+}
+
+/**
+ * @param n number of grid points along each axis
+ * @return parameters of a simulation of a channel flow around an obstacle on an n x n grid
+ */
+static SimulationParams channelParams(const uint32_t n)
+{
+	const BoundaryCond wall(BoundaryCondType::Dirichlet, vec2d(0, 0), BoundaryCondType::Neumann, 0);
+	const BoundaryCond inflow(BoundaryCondType::Dirichlet, vec2d(1, 0), BoundaryCondType::Neumann, 0);
+	const BoundaryCond outflow(BoundaryCondType::Neumann, vec2d(0, 0), BoundaryCondType::Dirichlet, 0);
+	ObstacleShapeStack stack;
+	stack.push(make_shared<ObstacleEllipse>(false, vec2d(.4, .5), .1, .1));
+	return SimulationParams(1, 1, n, n, 1e-4, inflow, outflow, wall, wall, 1, 1, stack, -1, 1, 10);
+}
+
+void Tests::testPressureExtrapolation()
+{
+	// the extrapolation only changes the initial guess, so the fields must agree up to the solver tolerance
+	const uint32_t n = 32, steps = 20;
+	auto simulate = [&](const PressureSolverType solver, const PressureExtrapolation extrapolation)
+	{
+		SimulationParams params = channelParams(n);
+		params.pressureSolver = solver;
+		params.pressureExtrapolation = extrapolation;
+		uptr<SimulatorClassic> sim = make_unique<SimulatorClassic>(params);
+		for (uint32_t i = 0; i < steps; i++)
+			sim->iter();
+		assert(!sim->crashed && sim->computedSteps == steps && sim->pressureIterations >= steps);
+		return sim;
+	};
+	for (const PressureSolverType solver : {PressureSolverType::Relaxation, PressureSolverType::Multigrid})
+	{
+		const uptr<SimulatorClassic> reference = simulate(solver, PressureExtrapolationNone);
+		double maxP = 0;
+		for (uint32_t i = 0; i < n * n; i++)
+			maxP = std::max(maxP, std::abs(reference->f1.p.data[i]));
+		for (const PressureExtrapolation extrapolation : {PressureExtrapolationLinear, PressureExtrapolationQuadratic})
+		{
+			const uptr<SimulatorClassic> sim = simulate(solver, extrapolation);
+			for (uint32_t y = 0; y < n; y++)
+			{
+				for (uint32_t x = 0; x < n; x++)
+				{
+					assert(std::abs(sim->f1.p(x, y) - reference->f1.p(x, y)) <= 1e-3 * maxP);
+					assert(std::abs(sim->f1.u.xRow(y)[x] - reference->f1.u.xRow(y)[x]) <= 1e-6);
+					assert(std::abs(sim->f1.u.yRow(y)[x] - reference->f1.u.yRow(y)[x]) <= 1e-6);
+				}
+			}
+		}
+	}
+
+	// with a variable time step, the guess is exact for pressure linear (quadratic) in time
+	for (const PressureExtrapolation extrapolation : {PressureExtrapolationLinear, PressureExtrapolationQuadratic})
+	{
+		SimulationParams params = channelParams(n);
+		params.pressureExtrapolation = extrapolation;
+		SimulatorClassic sim(params);
+		const bool quadratic = extrapolation == PressureExtrapolationQuadratic;
+		auto exact = [quadratic](const uint32_t i, const double t) { return std::sin(i * .1) + std::cos(i * .3) * t + (quadratic ? (i % 7) * t * t : 0); };
+		// the times of the fields relative to the last one
+		const double tPrev = -.3, tOlder = -1;
+		sim.pressureHistory = quadratic ? 3 : 2;
+		sim.lastDt = -tPrev;
+		sim.prevDt = tPrev - tOlder;
+		sim.dt = .2;
+		for (uint32_t i = 0; i < n * n; i++)
+		{
+			sim.f0.p.data[i] = exact(i, 0);
+			sim.f1.p.data[i] = exact(i, tPrev);
+			if (quadratic)
+				sim.olderP.data[i] = exact(i, tOlder);
+		}
+		sim.extrapolatePressure();
+		for (uint32_t i = 0; i < n * n; i++)
+			assert(std::abs(sim.f1.p.data[i] - exact(i, sim.dt)) <= 1e-12);
+	}
+}
+
+void Tests::testPressureStopping()
+{
+	const uint32_t n = 32, steps = 5;
+	SimulationParams params = channelParams(n);
+	params.pressureSolver = PressureSolverType::Relaxation;
+	params.pressureStopCriterion = PressureStopResidual;
+	params.pressureTolerance = 1e-4;
+	params.residualCheckPeriod = 4;
+	SimulatorClassic residualStopped(params);
+	params.pressureIterationCap = 7;
+	SimulatorClassic capped(params);
+	params.pressureSolver = PressureSolverType::Multigrid;
+	params.pressureIterationCap = 1;
+	SimulatorClassic cappedMultigrid(params);
+	params.pressureSolver = PressureSolverType::Cholesky;
+	SimulatorClassic direct(params);
+	for (uint32_t i = 0; i < steps; i++)
+	{
+		residualStopped.iter();
+		capped.iter();
+		cappedMultigrid.iter();
+		direct.iter();
+		// the cap applies to the iterative solvers as well
+		assert(!cappedMultigrid.crashed && cappedMultigrid.f1.pressureIterations == 1);
+		// the relaxation stops at a check of the residual once it is within the tolerance
+		assert(!residualStopped.crashed && residualStopped.f1.pressureResidual <= 1e-4);
+		assert(residualStopped.f1.pressureIterations > 0 && residualStopped.f1.pressureIterations % 4 == 0);
+		// the cap stops it before
+		assert(!capped.crashed && capped.f1.pressureIterations == 7 && capped.f1.pressureResidual > 1e-4);
+		// the direct solver solves the same equation as the relaxation
+		assert(!direct.crashed && direct.f1.pressureIterations == 1 && direct.f1.pressureResidual < 1e-9);
+	}
+	assert(residualStopped.pressureIterations > capped.pressureIterations);
+}
+
+void Tests::testMixedPrecision()
+{
+	// the corrections relaxed in single precision are added to the pressure in double precision, so the residual falls below the tolerance as well
+	const uint32_t n = 32, steps = 5;
+	SimulationParams params = channelParams(n);
+	params.pressureSolver = PressureSolverType::Relaxation;
+	params.pressureStopCriterion = PressureStopResidual;
+	params.pressureTolerance = 1e-9;
+	SimulatorClassic reference(params);
+	params.relaxationPrecision = RelaxationPrecisionMixed;
+	SimulatorClassic mixed(params);
+	for (uint32_t i = 0; i < steps; i++)
+	{
+		reference.iter();
+		mixed.iter();
+		assert(!mixed.crashed && mixed.f1.pressureResidual <= 1e-9);
+	}
+	double maxP = 0;
+	for (uint32_t i = 0; i < n * n; i++)
+		maxP = std::max(maxP, std::abs(reference.f1.p.data[i]));
+	for (uint32_t y = 0; y < n; y++)
+	{
+		for (uint32_t x = 0; x < n; x++)
+		{
+			assert(std::abs(mixed.f1.p(x, y) - reference.f1.p(x, y)) <= 1e-6 * maxP);
+			assert(std::abs(mixed.f1.u.xRow(y)[x] - reference.f1.u.xRow(y)[x]) <= 1e-9);
+			assert(std::abs(mixed.f1.u.yRow(y)[x] - reference.f1.u.yRow(y)[x]) <= 1e-9);
+		}
+	}
+}
+
+void Tests::testAdaptiveTimeStep()
+{
+	const uint32_t n = 32, frames = 2;
+	// a bound above 1 is capped at 1 with the upwind advection
+	for (const double courantNumber : {.5, 5.})
+	{
+		SimulationParams params = channelParams(n);
+		params.timeStepping = TimeSteppingAdaptive;
+		params.dt = 1e-3;
+		params.courantNumber = courantNumber;
+		SimulatorClassic sim(params);
+		const double rdx = 1 / params.get_dx(), rdy = 1 / params.get_dy();
+		const double viscousRate = 2 * params.mu / params.rho * (rdx * rdx + rdy * rdy);
+		uint64_t steps = 0;
+		for (uint32_t frame = 1; frame <= frames; frame++)
+		{
+			const double frameEnd = frame * params.getFrameTime();
+			while (sim.time < frameEnd)
+			{
+				sim.stepUntil = frameEnd;
+				sim.iter();
+				assert(!sim.crashed && sim.f1.dt > 0 && sim.f1.dt <= params.dt);
+				// the step satisfies the bound on the Courant number with the velocity it started from
+				double rate = 0;
+				for (uint32_t y = 0; y < n; y++)
+					for (uint32_t x = 0; x < n; x++)
+						rate = std::max(rate, std::abs(sim.f0.u.xRow(y)[x]) * rdx + std::abs(sim.f0.u.yRow(y)[x]) * rdy);
+				assert(sim.f1.dt * (rate + viscousRate) <= std::min(courantNumber, 1.) * (1 + 1e-12));
+				steps++;
+			}
+			// the last step of the frame lands exactly on its time
+			assert(sim.time == frameEnd);
+		}
+		// the viscous limit is far below the upper bound on the time step
+		assert(steps > frames * params.stepsPerFrame && sim.computedSteps == steps);
+	}
+}
+
+void Tests::testSemiLagrangianAdvection()
+{
+	// a uniform flow is advected exactly by both interpolations
+	{
+		const uint32_t n = 16;
+		Vec2dGrid u(n, n), ww(n, n);
+		u.set_all(vec2d(1, -.5));
+		BitGrid solid(n, n), indep(n, n);
+		solid.set_all(false);
+		indep.set_all(true);
+		for (const bool cubic : {false, true})
+		{
+			ww.set_all(vec2d(0, 0));
+			for (uint32_t y = 1; y < n - 1; y++)
+				StencilKernels::semiLagrangianRow(u, solid, indep, ww, y, .1, .05, .05, cubic);
+			for (uint32_t y = 1; y < n - 1; y++)
+			{
+				for (uint32_t x = 1; x < n - 1; x++)
+				{
+					assert(ww.xRow(y)[x] == 1 && ww.yRow(y)[x] == -.5);
+				}
+			}
+		}
+	}
+	// with a low viscosity, a time step several times above the CFL limit of the explicit scheme crashes the upwind advection,
+	// but the semi-Lagrangian advection neither crashes nor creates velocities beyond the range of the flow
+	const uint32_t n = 32;
+	SimulationParams params = channelParams(n);
+	params.pressureSolver = PressureSolverType::Multigrid;
+	params.mu = 1e-3;
+	params.dt = .05;
+	SimulatorClassic upwind(params);
+	for (uint32_t i = 0; i < 20 && !upwind.crashed; i++)
+		upwind.iter();
+	assert(upwind.crashed);
+	for (const AdvectionScheme advection : {AdvectionSemiLagrangianLinear, AdvectionSemiLagrangianCubic})
+	{
+		params.advection = advection;
+		SimulatorClassic sim(params);
+		for (uint32_t i = 0; i < 20; i++)
+			sim.iter();
+		assert(!sim.crashed);
+		double maxU = 0;
+		for (uint32_t y = 0; y < n; y++)
+			for (uint32_t x = 0; x < n; x++)
+				maxU = std::max({maxU, std::abs(sim.f1.u.xRow(y)[x]), std::abs(sim.f1.u.yRow(y)[x])});
+		assert(maxU < 2);
+	}
+	// with a high viscosity and the same small time step as the explicit scheme, the implicit viscous step gives nearly the same flow
+	params = channelParams(n);
+	params.pressureSolver = PressureSolverType::Multigrid;
+	SimulatorClassic reference(params);
+	params.advection = AdvectionSemiLagrangianLinear;
+	SimulatorClassic implicit(params);
+	for (uint32_t i = 0; i < 500; i++)
+	{
+		reference.iter();
+		implicit.iter();
+	}
+	assert(!implicit.crashed);
+	double maxDiff = 0;
+	for (uint32_t y = 0; y < n; y++)
+		for (uint32_t x = 0; x < n; x++)
+			maxDiff = std::max({maxDiff, std::abs(implicit.f1.u.xRow(y)[x] - reference.f1.u.xRow(y)[x]), std::abs(implicit.f1.u.yRow(y)[x] - reference.f1.u.yRow(y)[x])});
+	assert(maxDiff < .05);
+}
+
+void Tests::testBandedSteps()
+{
+	// the rows of w and of the RHS at the borders of the bands are computed in a separate pass, so the bands must give the same fields as a single one;
+	// the same holds for the relaxation, whose sweeps are blocked on the larger grid
+	const uint32_t steps = 3;
+	for (const uint32_t n : {128, 768})
+	{
+		for (const CellIterationMode mode : {CellIterationRows, CellIterationSpans})
+		{
+			SimulationParams params = channelParams(n);
+			// a Neumann b.c. for velocity at y = h makes the edge row depend on the last inner row
+			params.bcy1 = BoundaryCond(BoundaryCondType::Neumann, vec2d(0, 0), BoundaryCondType::Dirichlet, 0);
+			params.pressureSolver = PressureSolverType::Relaxation;
+			params.pressureIterationCap = 10;
+			params.cellIteration = mode;
+			params.threadCount = 1;
+			SimulatorClassic single(params);
+			params.threadCount = 4;
+			SimulatorClassic banded(params);
+			for (uint32_t i = 0; i < steps; i++)
+			{
+				single.iter();
+				banded.iter();
+			}
+			assert(!single.crashed && !banded.crashed);
+			for (uint32_t y = 0; y < n; y++)
+			{
+				for (uint32_t x = 0; x < n; x++)
+				{
+					assert(single.f1.p(x, y) == banded.f1.p(x, y));
+					assert(single.f1.u.xRow(y)[x] == banded.f1.u.xRow(y)[x]);
+					assert(single.f1.u.yRow(y)[x] == banded.f1.u.yRow(y)[x]);
+				}
+			}
+		}
+	}
+}
+
+void Tests::testBlockedRelaxation()
+{
+	// the blocked sweeps must give the same fields as the sweeps over the whole grid one at a time (the blocks end at the cap and at the checks of the residual)
+	const uint32_t n = 96, steps = 3;
+	for (const RelaxationPrecision precision : {RelaxationPrecisionDouble, RelaxationPrecisionMixed})
+	{
+		for (const PressureStopCriterion criterion : {PressureStopResidual, PressureStopChange})
+		{
+			SimulationParams params = channelParams(n);
+			params.pressureSolver = PressureSolverType::Relaxation;
+			params.relaxationPrecision = precision;
+			params.pressureStopCriterion = criterion;
+			params.pressureTolerance = 1e-12;
+			params.residualCheckPeriod = 3;
+			params.pressureIterationCap = 14;
+			params.threadCount = 2;
+			SimulatorClassic unblocked(params);
+			SimulatorClassic blocked(params);
+			// the grid is below the size from which the sweeps are blocked, but its bands are tall enough for the blocks
+			assert(unblocked.blockSweeps == 1 && (n - 2) / blocked.bandCount >= 4 * SimulatorClassic::TemporalBlockSweeps);
+			blocked.blockSweeps = SimulatorClassic::TemporalBlockSweeps;
+			for (uint32_t i = 0; i < steps; i++)
+			{
+				unblocked.iter();
+				blocked.iter();
+				assert(!unblocked.crashed && !blocked.crashed);
+				// the change criterion is only checked at the ends of the blocks, so neither of the runs may stop on it before the cap
+				assert(unblocked.f1.pressureIterations == blocked.f1.pressureIterations);
+			}
+			for (uint32_t y = 0; y < n; y++)
+			{
+				for (uint32_t x = 0; x < n; x++)
+				{
+					assert(unblocked.f1.p(x, y) == blocked.f1.p(x, y));
+					assert(unblocked.f1.u.xRow(y)[x] == blocked.f1.u.xRow(y)[x]);
+					assert(unblocked.f1.u.yRow(y)[x] == blocked.f1.u.yRow(y)[x]);
+				}
+			}
+		}
+	}
+}
+
+void Tests::testThreadPool()
+{
+	ThreadPool pool(4);
+	assert(pool.getThreadCount() == 4);
+	vec<uint32_t> hits(1000, 0);
+	for (uint32_t rep = 0; rep < 50; rep++)
+		pool.run(hits.size(), [&hits](const uint32_t i) { hits[i]++; });
+	for (const uint32_t h : hits)
+		assert(h == 50);
+
+	ThreadPool single(1);
+	uint32_t sm = 0;
+	single.run(10, [&sm](const uint32_t i) { sm += i; });
+	assert(sm == 45);
+}
+
+void Tests::testStencilKernels()
+{
+	// the kernels must agree with the point-by-point evaluation with the vec2d operators up to rounding errors
+	const uint32_t w = 37, h = 3;
+	const double dt = .01, nu = .7, rho = 1.3, dx = .1, dy = .15, crashLimit = 1e13;
+	Vec2dGrid u(w, h), ww(w, h), uNew(w, h);
+	// the reference formulas read the entries as vec2d values through const views
+	const Vec2dGrid &cu = u, &cww = ww, &cuNew = uNew;
+	Grid<double> p(w, h), field(w, h);
+	BitGrid indep(w, h);
+	for (uint32_t y = 0; y < h; y++)
+	{
+		assert(reinterpret_cast<uintptr_t>(u.xRow(y)) % Vec2dGrid::Alignment == 0);
+		assert(reinterpret_cast<uintptr_t>(u.yRow(y)) % Vec2dGrid::Alignment == 0);
+		for (uint32_t x = 0; x < w; x++)
+		{
+			u(x, y) = vec2d(std::sin(x * 1.3 + y * .7), std::cos(x * .9 - y * 1.1));
+			p(x, y) = std::sin(x * .4 + y * 2.1);
+			indep(x, y) = (x * 7 + y) % 5 != 0;
+		}
+	}
+	assert(cu(2, 1).x == u.xRow(1)[2] && cu(2, 1).y == u.yRow(1)[2]);
+	ww.set_all(vec2d(0, 0));
+	uNew.set_all(vec2d(0, 0));
+	field.set_all(0);
+	auto close = [](const double a, const double b) { return std::abs(a - b) <= 1e-12 * std::max(1., std::abs(b)); };
+	auto closeVec = [&close](const vec2d a, const vec2d b) { return close(a.x, b.x) && close(a.y, b.y); };
+
+	const uint32_t y = 1;
+	StencilKernels::advectDiffuseRow(u, indep, ww, y, dt, nu, dx, dy);
+	for (uint32_t x = 1; x < w - 1; x++)
+	{
+		const vec2d lapu = (cu(x + 1, y) - 2 * cu(x, y) + cu(x - 1, y)) / (dx * dx)
+			+ (cu(x, y + 1) - 2 * cu(x, y) + cu(x, y - 1)) / (dy * dy);
+		const vec2d convec = cu(x, y).x * (cu(x, y).x > 0 ? cu(x, y) - cu(x - 1, y) : cu(x + 1, y) - cu(x, y)) / dx
+			+ cu(x, y).y * (cu(x, y).y > 0 ? cu(x, y) - cu(x, y - 1) : cu(x, y + 1) - cu(x, y)) / dy;
+		assert(closeVec(cww(x, y), indep(x, y) ? cu(x, y) + dt * (nu * lapu - convec) : vec2d(0, 0)));
+	}
+	ww.set_all(vec2d(.5, -.25));
+	ww(3, y) = vec2d(1e20, 0);
+	assert(!StencilKernels::divergenceRow(u, indep, field, y, rho, dt, dx, dy, crashLimit));
+	for (uint32_t x = 1; x < w - 1; x++)
+	{
+		const double f = rho / dt * ((cu(x + 1, y).x - cu(x - 1, y).x) / (2 * dx) + (cu(x, y + 1).y - cu(x, y - 1).y) / (2 * dy));
+		assert(close(field(x, y), indep(x, y) ? f : 0));
+	}
+	assert(StencilKernels::divergenceRow(ww, indep, field, y, rho, dt, dx, dy, crashLimit));
+	assert(!StencilKernels::projectRow(u, p, indep, uNew, y, rho, dt, dx, dy));
+	for (uint32_t x = 1; x < w - 1; x++)
+	{
+		const vec2d expected(cu(x, y).x - dt / rho * (p(x + 1, y) - p(x - 1, y)) / (2 * dx),
+			cu(x, y).y - dt / rho * (p(x, y + 1) - p(x, y - 1)) / (2 * dy));
+		assert(closeVec(cuNew(x, y), indep(x, y) ? expected : vec2d(0, 0)));
+	}
+
+	// the relaxation with the precomputed stencil must agree with the point-by-point evaluation of the equation
+	Grid<uint8_t> mask(w, h);
+	Grid<double> invDiag(w, h), pNew(p);
+	mask.set_all(0);
+	invDiag.set_all(0);
+	for (uint32_t x = 1; x < w - 1; x++)
+	{
+		mask(x, y) = (x % 3 != 0 ? RelaxUnknown : 0) | (x % 4 != 0 ? RelaxRight : 0) | RelaxLeft | (x % 5 != 0 ? RelaxUp : 0) | RelaxDown;
+		const double coef = dy * dy * (mask(x, y) & RelaxRight ? 2 : 1) + dx * dx * (mask(x, y) & RelaxUp ? 2 : 1);
+		invDiag(x, y) = mask(x, y) & RelaxUnknown ? 1 / coef : 0;
+	}
+	const double dl1 = StencilKernels::relaxRow(pNew, field, mask, invDiag, y, 1, dx, dy, 1);
+	double expectedDl1 = 1;
+	for (uint32_t x = 1; x < w - 1; x++)
+	{
+		if (x % 2 == 0 || !(mask(x, y) & RelaxUnknown))
+		{
+			assert(pNew(x, y) == p(x, y));
+			continue;
+		}
+		const double sm = dy * dy * ((mask(x, y) & RelaxRight ? p(x + 1, y) : 0) + pNew(x - 1, y))
+			+ dx * dx * ((mask(x, y) & RelaxUp ? p(x, y + 1) : 0) + p(x, y - 1));
+		const double expected = (sm - dx * dx * dy * dy * field(x, y)) * invDiag(x, y) * 1.5 - .5 * p(x, y);
+		assert(close(pNew(x, y), expected));
+		expectedDl1 += std::abs(p(x, y) - expected);
+	}
+	assert(close(dl1, expectedDl1));
+
+	// the residual must agree with the point-by-point evaluation of the laplacian of the pressure minus the RHS
+	double fieldSq = 1;
+	const double residualSq = StencilKernels::residualRow(pNew, field, mask, y, dx, dy, fieldSq);
+	double expectedResidualSq = 0, expectedFieldSq = 1;
+	for (uint32_t x = 1; x < w - 1; x++)
+	{
+		if (!(mask(x, y) & RelaxUnknown))
+			continue;
+		const double lap = ((mask(x, y) & RelaxRight ? pNew(x + 1, y) - pNew(x, y) : 0) + pNew(x - 1, y) - pNew(x, y)) / (dx * dx)
+			+ ((mask(x, y) & RelaxUp ? pNew(x, y + 1) - pNew(x, y) : 0) + pNew(x, y - 1) - pNew(x, y)) / (dy * dy);
+		expectedResidualSq += (lap - field(x, y)) * (lap - field(x, y));
+		expectedFieldSq += field(x, y) * field(x, y);
+	}
+	assert(std::abs(residualSq - expectedResidualSq) <= 1e-9 * expectedResidualSq && close(fieldSq, expectedFieldSq));
+
+	// the span kernels applied to the runs of independent points of the row must give exactly the results of the row kernels
+	// (the points at the edges are never independent)
+	indep(0, y) = indep(w - 1, y) = false;
+	vec<GridRun> runs;
+	indep.forEachRun(y, [&runs](const GridRun &run) { runs.push_back(run); });
+	assert(runs.size() > 1 && runs.front().x0 == 1 && runs.back().x1 == w - 1);
+	Vec2dGrid wwRow(w, h), wwSpans(w, h), uRow(w, h), uSpans(w, h);
+	Grid<double> fieldRow(w, h), fieldSpans(w, h), pRow(p), pSpans(p);
+	for (Vec2dGrid *g : {&wwRow, &wwSpans, &uRow, &uSpans})
+		g->set_all(vec2d(0, 0));
+	fieldRow.set_all(0);
+	fieldSpans.set_all(0);
+	// only the independent points can be unknowns
+	for (uint32_t x = 1; x < w - 1; x++)
+		if (!indep(x, y))
+			mask(x, y) &= ~RelaxUnknown;
+	StencilKernels::advectDiffuseRow(u, indep, wwRow, y, dt, nu, dx, dy);
+	assert(!StencilKernels::divergenceRow(wwRow, indep, fieldRow, y, rho, dt, dx, dy, crashLimit));
+	assert(!StencilKernels::projectRow(wwRow, p, indep, uRow, y, rho, dt, dx, dy));
+	double rowDl1 = StencilKernels::relaxRow(pRow, fieldRow, mask, invDiag, y, 2, dx, dy, 0);
+	double spansDl1 = 0;
+	for (const GridRun &run : runs)
+	{
+		StencilKernels::advectDiffuseSpan(u, wwSpans, run, dt, nu, dx, dy);
+		assert(!StencilKernels::divergenceSpan(wwRow, fieldSpans, run, rho, dt, dx, dy, crashLimit));
+		assert(!StencilKernels::projectSpan(wwRow, p, uSpans, run, rho, dt, dx, dy));
+		spansDl1 = StencilKernels::relaxSpan(pSpans, fieldRow, mask, invDiag, run, 2, dx, dy, spansDl1);
+	}
+	for (uint32_t x = 0; x < w; x++)
+	{
+		assert(wwRow.xRow(y)[x] == wwSpans.xRow(y)[x] && wwRow.yRow(y)[x] == wwSpans.yRow(y)[x]);
+		assert(uRow.xRow(y)[x] == uSpans.xRow(y)[x] && uRow.yRow(y)[x] == uSpans.yRow(y)[x]);
+		assert(fieldRow(x, y) == fieldSpans(x, y));
+		assert(pRow(x, y) == pSpans(x, y));
+	}
+	assert(rowDl1 == spansDl1 && rowDl1 > 0);
+
+	// the interior kernel must agree with the general one on a run of interior unknowns
+	const GridRun interiorRun{y, 3, w - 4};
+	for (uint32_t x = interiorRun.x0; x < interiorRun.x1; x++)
+	{
+		mask(x, y) = RelaxInterior;
+		invDiag(x, y) = 1 / (2 * dx * dx + 2 * dy * dy);
+	}
+	Grid<double> pGeneral(p), pInterior(p);
+	for (uint32_t parity = 0; parity < 2; parity++)
+	{
+		const double generalDl1 = StencilKernels::relaxSpan(pGeneral, fieldRow, mask, invDiag, interiorRun, parity, dx, dy, 0);
+		const double interiorDl1 = StencilKernels::relaxInteriorSpan(pInterior, fieldRow, interiorRun, parity, dx, dy, 0);
+		assert(close(interiorDl1, generalDl1) && generalDl1 > 0);
+	}
+	for (uint32_t x = 0; x < w; x++)
+		assert(close(pInterior(x, y), pGeneral(x, y)));
+}
+
+void Tests::testFrameMoves()
+{
+	SimFrame f0(Grid<double>(3, 2), Vec2dGrid(3, 2)), f1(Grid<double>(3, 2), Vec2dGrid(3, 2));
+	f0.p.set_all(1);
+	f0.u.set_all(vec2d(2, 3));
+	f1.p.set_all(4);
+	f1.u.set_all(vec2d(5, 6));
+	const double *const p0 = f0.p.data, *const u0 = f0.u.data;
+	// swapping the frames exchanges their buffers without copying
+	std::swap(f0, f1);
+	assert(f1.p.data == p0 && f1.u.data == u0);
+	assert(f0.p(2, 1) == 4 && f0.u(2, 1).y == 6);
+	assert(f1.p(2, 1) == 1 && f1.u(2, 1).x == 2);
+	// a moved-from frame is left empty and can be assigned to again
+	SimFrame f2(std::move(f1));
+	assert(f2.p.data == p0 && f2.u.data == u0);
+	assert(f1.p.data == nullptr && f1.u.data == nullptr && f1.p.w == 0 && f1.u.h == 0);
+	f1 = f0;
+	assert(f1.p(0, 0) == 4 && f1.p.data != f0.p.data);
+	f0 = std::move(f2);
+	assert(f0.p.data == p0 && f0.p(1, 1) == 1);
+}
+
+void Tests::testBitGrid()
+{
+	// a width that isn't a multiple of the word size, so that the last word of each row is only partially used
+	const uint32_t w = 150, h = 3;
+	BitGrid g(w, h);
+	assert(g.words == 3);
+	g.set_all(true);
+	assert(g.count() == w * h);
+	g.set_all(false);
+	assert(g.count() == 0);
+	// a span crossing two word boundaries and a span within a single word
+	g.set_span(1, 10, 140, true);
+	g.set_span(2, 64, 65, true);
+	g(3, 0) = true;
+	g(149, 0) = g(3, 0);
+	g(100, 1) = false;
+	assert(g.count() == 130 - 1 + 1 + 2);
+	const BitGrid &cg = g;
+	for (uint32_t x = 0; x < w; x++)
+	{
+		assert(cg(x, 1) == (x >= 10 && x < 140 && x != 100));
+		assert(cg(x, 2) == (x == 64));
+		assert(cg(x, 0) == (x == 3 || x == 149));
+	}
+	BitGrid other(w, h);
+	other.set_all(false);
+	other.set_span(1, 0, w, true);
+	BitGrid united = g;
+	united.unite(other);
+	assert(united.count() == w + 1 + 2);
+	BitGrid difference = g;
+	difference.subtract(other);
+	assert(difference.count() == 3 && difference(64, 2) && !difference(20, 1));
+	// the original is unaffected by the operations on its copies
+	assert(g.count() == 130 - 1 + 1 + 2);
+	vec<GridRun> runs;
+	for (uint32_t y = 0; y < h; y++)
+		united.forEachRun(y, [&runs](const GridRun &run) { runs.push_back(run); });
+	assert(runs.size() == 4);
+	assert(runs[0].y == 0 && runs[0].x0 == 3 && runs[0].x1 == 4 && runs[1].x0 == 149 && runs[1].x1 == w);
+	assert(runs[2].y == 1 && runs[2].x0 == 0 && runs[2].x1 == w && runs[3].y == 2 && runs[3].x0 == 64 && runs[3].x1 == 65);
+	BitGrid moved(std::move(difference));
+	assert(moved.count() == 3 && difference.data == nullptr && difference.w == 0);
+}
+
+void Tests::testConnectedComponents()
+{
+	// a U shape whose arms only meet in the last row (so it is merged across the seams of the bands), an isolated point,
+	// and a diagonal pair of points (which aren't neighbors)
+	const char *const rows[] = {
+		"#..#.#",
+		"#..#..",
+		"#..#.#",
+		"####..",
+		"......",
+		"#.....",
+		".#...."
+	};
+	const uint32_t w = 6, h = 7;
+	BitGrid mask(w, h);
+	for (uint32_t y = 0; y < h; y++)
+		for (uint32_t x = 0; x < w; x++)
+			mask(x, y) = rows[y][x] == '#';
+	for (uint32_t threads = 1; threads <= 4; threads++)
+	{
+		ThreadPool pool(threads);
+		Grid<uint32_t> labels(w, h);
+		ConnectedComponents::label(mask, labels, pool);
+		for (uint32_t y = 0; y < h; y++)
+			for (uint32_t x = 0; x < w; x++)
+				assert((labels(x, y) == ConnectedComponents::NoComponent) == !mask(x, y));
+		assert(labels(3, 0) == 0 && labels(0, 2) == 0 && labels(3, 2) == 0 && labels(2, 3) == 0);
+		assert(labels(5, 0) == 5 && labels(5, 2) == 5 + 2 * w);
+		assert(labels(0, 5) == 5 * w && labels(1, 6) == 1 + 6 * w);
+	}
+}
+
+void Tests::testDomainGeometry()
+{
+	// a wall across the whole container separating its right part (which has no point with set pressure, so it has to be pinned)
+	// from the left side, where the pressure is set
+	const BoundaryCond wall(BoundaryCondType::Dirichlet, vec2d(0, 0), BoundaryCondType::Neumann, 0);
+	const BoundaryCond inflow(BoundaryCondType::Dirichlet, vec2d(1, 0), BoundaryCondType::Dirichlet, 1);
+	ObstacleShapeStack stack;
+	stack.push(make_shared<ObstacleRectangle>(false, vec2d(.42, -.1), vec2d(.58, 1.1)));
+	SimulationParams params(1, 1, 21, 21, .001, inflow, wall, wall, wall, 1, 1, stack, -1, 1, 10);
+	params.threadCount = 2;
+	const sptr<const DomainGeometry> geometry = DomainGeometry::create(params);
+	const DomainGeometry &g = *geometry;
+	BitGrid solid(21, 21);
+	stack.set(solid);
+	uint32_t pinned = 0;
+	for (uint32_t y = 0; y < 21; y++)
+	{
+		for (uint32_t x = 0; x < 21; x++)
+		{
+			assert(g.solid(x, y) == solid(x, y));
+			const bool inner = x != 0 && x != 20 && y != 0 && y != 20;
+			assert(g.indep(x, y) == (inner && !solid(x, y) && !solid(x - 1, y) && !solid(x + 1, y) && !solid(x, y - 1) && !solid(x, y + 1)));
+			if (x == 0)
+				assert(g.dirichlet(x, y));
+			else if (g.dirichlet(x, y))
+			{
+				// the only pinned point is the first point of the right part
+				assert(inner && g.component(x, y) == x + y * 21u);
+				assert(x > 12 && y == 1);
+				pinned++;
+			}
+		}
+	}
+	assert(pinned == 1 && g.pinnedPoints.size() == 1);
+	assert(g.dirichlet(g.pinnedPoints[0]));
+	for (const ObstacleBoundaryPoint &bp : g.obstacleBoundary)
+	{
+		const uint32_t x = bp.pos.x, y = bp.pos.y;
+		assert(!g.solid(x, y) && !g.indep(x, y));
+		assert(bp.indepNeighbors == (g.indep(x - 1, y) | g.indep(x + 1, y) << 1 | g.indep(x, y - 1) << 2 | g.indep(x, y + 1) << 3));
+	}
+	assert(!g.obstacleBoundary.empty());
+	// the runs cover exactly the independent points
+	uint64_t runPoints = 0;
+	for (uint32_t y = 0; y < 21; y++)
+	{
+		for (uint32_t r = g.indepRowRuns[y]; r < g.indepRowRuns[y + 1]; r++)
+		{
+			const GridRun &run = g.indepRuns[r];
+			assert(run.y == y && run.x0 < run.x1 && g.indep(run.x0, y) && g.indep(run.x1 - 1, y) && !g.indep(run.x0 - 1, y) && !g.indep(run.x1, y));
+			runPoints += run.x1 - run.x0;
+		}
+	}
+	assert(runPoints == g.indep.count() && g.indepRowRuns.back() == g.indepRuns.size());
 }
 
 void Tests::run()
 {
 	testConv();
 	testObstacleShapes();
+	testPressureSolvers();
+	testPressureExtrapolation();
+	testPressureStopping();
+	testMixedPrecision();
+	testAdaptiveTimeStep();
+	testSemiLagrangianAdvection();
+	testBandedSteps();
+	testBlockedRelaxation();
+	testThreadPool();
+	testStencilKernels();
+	testFrameMoves();
+	testBitGrid();
+	testConnectedComponents();
+	testDomainGeometry();
 }
 
 }
\ No newline at end of file
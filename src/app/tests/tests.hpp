@@ -15,6 +15,20 @@ class Tests
 private:
 	static void testConv();
 	static void testObstacleShapes();
+	static void testPressureSolvers();
+	static void testPressureExtrapolation();
+	static void testPressureStopping();
+	static void testMixedPrecision();
+	static void testAdaptiveTimeStep();
+	static void testSemiLagrangianAdvection();
+	static void testBandedSteps();
+	static void testBlockedRelaxation();
+	static void testThreadPool();
+	static void testStencilKernels();
+	static void testFrameMoves();
+	static void testBitGrid();
+	static void testConnectedComponents();
+	static void testDomainGeometry();
 	
 public:
 	static void run();
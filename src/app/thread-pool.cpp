@@ -0,0 +1,88 @@
+/**
+ * thread-pool.cpp
+ *
+ * Author: Viktor Fukala
+ * Created on 2026/10/17
+ */
+#include "thread-pool.hpp"
+
+namespace brandy0
+{
+
+ThreadPool::ThreadPool(const uint32_t threadCount)
+	: nextTask(0)
+{
+	for (uint32_t i = 1; i < threadCount; i++)
+		workers.emplace_back([this]{ runWorker(); });
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	startCv.notify_all();
+	for (std::thread &worker : workers)
+		worker.join();
+}
+
+uint32_t ThreadPool::getThreadCount() const
+{
+	return workers.size() + 1;
+}
+
+void ThreadPool::work(const std::function<void(uint32_t)> &fn, const uint32_t count)
+{
+	for (uint32_t i = nextTask++; i < count; i = nextTask++)
+		fn(i);
+}
+
+void ThreadPool::runWorker()
+{
+	uint64_t seenGeneration = 0;
+	while (true)
+	{
+		const std::function<void(uint32_t)> *fn;
+		uint32_t count;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			startCv.wait(lock, [this, seenGeneration]{ return stopping || generation != seenGeneration; });
+			if (stopping)
+				return;
+			seenGeneration = generation;
+			fn = task;
+			count = taskCount;
+		}
+		work(*fn, count);
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			busyWorkers--;
+		}
+		doneCv.notify_one();
+	}
+}
+
+void ThreadPool::run(const uint32_t count, const std::function<void(uint32_t)> &fn)
+{
+	if (workers.empty() || count <= 1)
+	{
+		for (uint32_t i = 0; i < count; i++)
+			fn(i);
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		task = &fn;
+		taskCount = count;
+		nextTask = 0;
+		busyWorkers = workers.size();
+		generation++;
+	}
+	startCv.notify_all();
+	work(fn, count);
+	std::unique_lock<std::mutex> lock(mutex);
+	doneCv.wait(lock, [this]{ return busyWorkers == 0; });
+}
+
+}
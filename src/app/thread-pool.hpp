@@ -0,0 +1,91 @@
+/**
+ * thread-pool.hpp
+ *
+ * Author: Viktor Fukala
+ * Created on 2026/10/17
+ */
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "vec.hpp"
+
+namespace brandy0
+{
+
+/**
+ * Pool of persistent worker threads running batches of indexed tasks.
+ *
+ * The thread calling run takes part in the computation, so a pool for n threads has n - 1 workers.
+ * The workers sleep between the batches, so that an idle pool doesn't consume CPU time.
+ */
+class ThreadPool
+{
+private:
+	/// Worker threads
+	vec<std::thread> workers;
+	/// Mutex guarding the batch state shared with the workers
+	std::mutex mutex;
+	/// Condition variable signalling the start of a batch (or the termination) to the workers
+	std::condition_variable startCv;
+	/// Condition variable signalling to the calling thread that the workers have finished the batch
+	std::condition_variable doneCv;
+	/// Function run for every task of the current batch (guarded by mutex)
+	const std::function<void(uint32_t)> *task = nullptr;
+	/// Number of tasks in the current batch (guarded by mutex)
+	uint32_t taskCount = 0;
+	/// Index of the next task of the current batch to be taken by a thread
+	std::atomic<uint32_t> nextTask;
+	/// Number of batches started so far (guarded by mutex); workers use it to recognize a new batch
+	uint64_t generation = 0;
+	/// Number of workers that haven't finished the current batch yet (guarded by mutex)
+	uint32_t busyWorkers = 0;
+	/// True iff the workers should terminate (guarded by mutex)
+	bool stopping = false;
+
+	/**
+	 * Takes and runs the tasks of the current batch until there are none left
+	 * @param fn function to run for every task
+	 * @param count number of tasks in the batch
+	 */
+	void work(const std::function<void(uint32_t)> &fn, uint32_t count);
+	/**
+	 * Main loop of a worker thread
+	 */
+	void runWorker();
+
+public:
+	/**
+	 * Constructs the pool and starts its workers
+	 * @param threadCount number of threads taking part in each batch (including the calling thread; at least 1)
+	 */
+	ThreadPool(uint32_t threadCount);
+	ThreadPool(const ThreadPool &) = delete;
+	ThreadPool &operator=(const ThreadPool &) = delete;
+	/**
+	 * Stops and joins the workers
+	 */
+	~ThreadPool();
+
+	/**
+	 * @return number of threads taking part in each batch (including the calling thread)
+	 */
+	uint32_t getThreadCount() const;
+	/**
+	 * Runs fn(i) for all i < count (in no particular order, possibly concurrently) and blocks until all of them finish.
+	 * Must not be called concurrently from multiple threads.
+	 * @param count number of tasks
+	 * @param fn function to run for every task
+	 */
+	void run(uint32_t count, const std::function<void(uint32_t)> &fn);
+};
+
+}
+
+#endif // THREAD_POOL_HPP
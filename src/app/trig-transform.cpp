@@ -0,0 +1,125 @@
+/**
+ * trig-transform.cpp
+ *
+ * Author: Viktor Fukala
+ * Created on 2026/10/17
+ */
+#include "trig-transform.hpp"
+
+#include <cmath>
+
+namespace brandy0
+{
+
+/**
+ * @param num numerator
+ * @param period period of the numerator (an integer or half-integer)
+ * @return exp(2 pi i * num / period), computed with num reduced modulo the period to preserve precision for large num
+ */
+std::complex<double> phase(const double num, const double period)
+{
+	return std::polar(1., 2 * M_PI * std::fmod(num, period) / period);
+}
+
+TrigTransform::TrigTransform(const uint32_t m, const double alpha, const double beta, const double d, const bool sine)
+	: m(m), sine(sine), pre(m), post(m)
+{
+	fftLen = 1;
+	while (fftLen < 2 * m - 1)
+		fftLen *= 2;
+	kernel.resize(fftLen);
+	buf.resize(fftLen);
+	twiddles.reserve(fftLen - 1);
+	for (uint32_t len = 2; len <= fftLen; len *= 2)
+	{
+		for (uint32_t k = 0; k < len / 2; k++)
+			twiddles.push_back(std::polar(1., -2 * M_PI * k / len));
+	}
+	bitReversed.resize(fftLen);
+	bitReversed[0] = 0;
+	for (uint32_t i = 1, j = 0; i < fftLen; i++)
+	{
+		uint32_t bit = fftLen >> 1;
+		for (; j & bit; bit >>= 1)
+			j ^= bit;
+		j ^= bit;
+		bitReversed[i] = j;
+	}
+
+	// (t + alpha) (j + beta) = t beta + alpha j + alpha beta + (t^2 + j^2 - (j - t)^2) / 2,
+	// so the sum is post_j * sum_t (pre_t in_t) * chirp(j - t), where chirp(k) = exp(-pi i k^2 / (2 d))
+	const double period = 4 * d;
+	for (uint32_t t = 0; t < m; t++)
+	{
+		const double sq = double(t) * t;
+		pre[t] = phase(2 * t * beta + sq, period);
+		post[t] = phase(2 * t * alpha + 2 * alpha * beta + sq, period);
+	}
+	std::fill(kernel.begin(), kernel.end(), 0);
+	for (uint32_t k = 0; k < m; k++)
+	{
+		kernel[k] = std::conj(phase(double(k) * k, period)) / double(fftLen);
+		if (k != 0)
+			kernel[fftLen - k] = kernel[k];
+	}
+	fft(kernel, false);
+}
+
+/**
+ * Multiplies two complex numbers (without the checks for infinities done by the standard operator)
+ */
+inline std::complex<double> mul(const std::complex<double> a, const std::complex<double> b)
+{
+	return std::complex<double>(a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real());
+}
+
+void TrigTransform::fft(vec<std::complex<double>> &a, const bool inverse) const
+{
+	for (uint32_t i = 0; i < fftLen; i++)
+	{
+		if (i < bitReversed[i])
+			std::swap(a[i], a[bitReversed[i]]);
+	}
+	const double sign = inverse ? -1 : 1;
+	// the twiddles of the stage with blocks of length len start at index len / 2 - 1
+	for (uint32_t len = 2; len <= fftLen; len *= 2)
+	{
+		const uint32_t half = len / 2;
+		const std::complex<double> *const tw = twiddles.data() + half - 1;
+		for (uint32_t i = 0; i < fftLen; i += len)
+		{
+			std::complex<double> *const lo = a.data() + i;
+			std::complex<double> *const hi = lo + half;
+			for (uint32_t k = 0; k < half; k++)
+			{
+				const std::complex<double> v = mul(hi[k], std::complex<double>(tw[k].real(), sign * tw[k].imag()));
+				hi[k] = lo[k] - v;
+				lo[k] += v;
+			}
+		}
+	}
+}
+
+void TrigTransform::apply(const double *const in, const uint32_t inStride, double *const out, const uint32_t outStride)
+{
+	for (uint32_t t = 0; t < m; t++)
+		buf[t] = pre[t] * in[t * inStride];
+	std::fill(buf.begin() + m, buf.end(), 0);
+	fft(buf, false);
+	for (uint32_t k = 0; k < fftLen; k++)
+		buf[k] = mul(buf[k], kernel[k]);
+	fft(buf, true);
+	for (uint32_t j = 0; j < m; j++)
+	{
+		const std::complex<double> z = mul(post[j], buf[j]);
+		out[j * outStride] = sine ? z.imag() : z.real();
+	}
+}
+
+uint64_t TrigTransform::getMemoryFootprint() const
+{
+	return (pre.capacity() + post.capacity() + kernel.capacity() + twiddles.capacity() + buf.capacity()) * sizeof(std::complex<double>)
+		+ bitReversed.capacity() * sizeof(uint32_t);
+}
+
+}
@@ -0,0 +1,83 @@
+/**
+ * trig-transform.hpp
+ *
+ * Author: Viktor Fukala
+ * Created on 2026/10/17
+ */
+#ifndef TRIG_TRANSFORM_HPP
+#define TRIG_TRANSFORM_HPP
+
+#include <complex>
+#include <cstdint>
+
+#include "vec.hpp"
+
+namespace brandy0
+{
+
+/**
+ * Fast evaluator of a discrete sine or cosine transform of a fixed length in the general form
+ * out_j = sum_{t = 0}^{m - 1} in_t * trig(pi * (t + alpha) * (j + beta) / d) for j = 0, ..., m - 1,
+ * where trig is either sin or cos.
+ *
+ * The sum is rewritten (by Bluestein's identity) as a convolution, which is evaluated by power-of-two FFTs.
+ * Hence, the transform takes O(m log m) time for any m, alpha, beta, and d.
+ */
+class TrigTransform
+{
+private:
+	/// Length of the transform
+	uint32_t m;
+	/// True iff the transform uses sin (otherwise it uses cos)
+	bool sine;
+	/// Length of the FFTs (a power of 2 at least 2m - 1)
+	uint32_t fftLen;
+	/// Factors the input is multiplied by before the convolution
+	vec<std::complex<double>> pre;
+	/// Factors the result of the convolution is multiplied by
+	vec<std::complex<double>> post;
+	/// FFT of the convolution kernel (already divided by fftLen to normalize the inverse FFT)
+	vec<std::complex<double>> kernel;
+	/// FFT twiddle factors exp(-2 pi i k / len) for k < len / 2 for every stage (len = 2, 4, ..., fftLen) of the FFT
+	vec<std::complex<double>> twiddles;
+	/// Bit-reversal permutation of the indices 0, ..., fftLen - 1
+	vec<uint32_t> bitReversed;
+	/// Work space for the FFTs
+	vec<std::complex<double>> buf;
+
+	/**
+	 * Performs an in-place FFT of length fftLen
+	 * @param a the data to transform
+	 * @param inverse true iff the inverse transform should be computed (without the normalization by 1 / fftLen)
+	 */
+	void fft(vec<std::complex<double>> &a, bool inverse) const;
+
+public:
+	/**
+	 * Constructs the transform (precomputes all the factors for the given parameters)
+	 * @param m length of the transform (at least 1)
+	 * @param alpha offset of the input index
+	 * @param beta offset of the output index
+	 * @param d period parameter of the transform; 4 * d must be an integer (so that the phases can be reduced exactly)
+	 * @param sine true iff the transform uses sin (otherwise it uses cos)
+	 */
+	TrigTransform(uint32_t m, double alpha, double beta, double d, bool sine);
+
+	/**
+	 * Applies the transform to a strided array
+	 * @param in pointer to the first element of the input
+	 * @param inStride distance between two consecutive elements of the input
+	 * @param out pointer to the first element of the output (may be the same as the input)
+	 * @param outStride distance between two consecutive elements of the output
+	 */
+	void apply(const double *in, uint32_t inStride, double *out, uint32_t outStride);
+
+	/**
+	 * @return number of bytes of memory allocated by the transform
+	 */
+	uint64_t getMemoryFootprint() const;
+};
+
+}
+
+#endif // TRIG_TRANSFORM_HPP
@@ -7,6 +7,7 @@
 #include "video-exporter.hpp"
 
 #include <filesystem>
+#include <utility>
 
 #include <glibmm.h>
 
@@ -46,6 +47,7 @@ void VideoExporter::detectFatalError(const str& message)
 
 VideoExporter::VideoExporter(
 		const SimulationParams& params,
+		sptr<const DomainGeometry> geometry,
 		const uint32_t backDisplayMode,
 		const uint32_t frontDisplayMode,
 		const str& filename,
@@ -59,7 +61,7 @@ VideoExporter::VideoExporter(
 		const uint32_t bitrate,
 		GraphicsManager *const graphicsManager
 	) :
-		drawer(params),
+		drawer(params, std::move(geometry)),
 		filename(filename),
 		frames(frames),
 		startTime(startTime),
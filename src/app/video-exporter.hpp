@@ -157,6 +157,7 @@ public:
 	 * This object can then be used to only export videos with parameters specified in this constructor.
 	 * To start the actual video export operation @see exportVideo
 	 * @param params simulation parameters of the simulation
+	 * @param geometry geometry of the simulated domain (shared with the simulator)
 	 * @param backDisplayMode background visual mode for the exported video
 	 * @param frontDisplayMode foreground visual mode for the exported video
 	 * @param filename name of the exported video file (might not work for filename not ending with ".mp4")
@@ -172,6 +173,7 @@ public:
 	 */
 	VideoExporter(
 		const SimulationParams &params,
+		sptr<const DomainGeometry> geometry,
 		uint32_t backDisplayMode,
 		uint32_t frontDisplayMode,
 		const str &filename,
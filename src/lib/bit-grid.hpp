@@ -0,0 +1,364 @@
+/**
+ * bit-grid.hpp
+ *
+ * Author: Viktor Fukala
+ * Created on 2026/10/17
+ */
+#ifndef BIT_GRID_HPP
+#define BIT_GRID_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+
+#include "point.hpp"
+
+namespace brandy0
+{
+
+/**
+ * Reference to an entry of a BitGrid (which is a single bit of a 64-bit word).
+ * Behaves like a reference to a bool: it can be read and a bool can be assigned to it.
+ */
+struct BitRef
+{
+	/// Reference to the word containing the entry
+	uint64_t &word;
+	/// Mask of the bit of the entry in the word
+	uint64_t bit;
+
+	/**
+	 * Constructs a reference to an entry given the word and the mask of its bit
+	 * @param word reference to the word containing the entry
+	 * @param bit mask with only the bit of the entry set
+	 */
+	BitRef(uint64_t &word, const uint64_t bit) : word(word), bit(bit)
+	{
+	}
+
+	BitRef(const BitRef &) = default;
+
+	/**
+	 * Assigns the value of another entry to this entry (the reference is not rebound)
+	 */
+	BitRef &operator=(const BitRef &other)
+	{
+		return *this = bool(other);
+	}
+
+	/**
+	 * Assigns a value to this entry
+	 */
+	BitRef &operator=(const bool val)
+	{
+		word = val ? word | bit : word & ~bit;
+		return *this;
+	}
+
+	/**
+	 * @return value of the entry
+	 */
+	operator bool() const
+	{
+		return word & bit;
+	}
+};
+
+/**
+ * Horizontal run of grid points
+ */
+struct GridRun
+{
+	/// Index of the row
+	uint32_t y;
+	/// Index of the first point of the run
+	uint32_t x0;
+	/// Index of the past-the-last point of the run
+	uint32_t x1;
+};
+
+/**
+ * Struct for holding a two-dimensional array of bools packed into 64-bit words (bit i of word j of a row is the entry at x = 64 * j + i).
+ * Each row starts at a new word and the bits past the end of a row are always zero,
+ * so the bulk operations and the counting can work with whole words.
+ *
+ * Concurrent writes of different entries are only safe if they are in different words (e.g. in different rows).
+ */
+struct BitGrid
+{
+	/// Number of entries per word
+	static constexpr uint32_t WordBits = 64;
+
+	/**
+	 * Pointer to the data (the words of the rows in row major order).
+	 * Should be nullptr iff either w or h is 0.
+	 */
+	uint64_t *data;
+	/// Width of the two-dimensional array
+	uint32_t w;
+	/// Height of the two-dimensional array
+	uint32_t h;
+	/// Number of words of each row
+	uint32_t words;
+
+	/**
+	 * Creates a BitGrid object of specified dimensions with all entries false
+	 * @param w width of the array
+	 * @param h height of the array
+	 */
+	BitGrid(const uint32_t w, const uint32_t h) : w(w), h(h), words((w + WordBits - 1) / WordBits)
+	{
+		allocate();
+	}
+
+	BitGrid(const BitGrid &g) : BitGrid(g.w, g.h)
+	{
+		if (data)
+			std::copy_n(g.data, size(), data);
+	}
+
+	/**
+	 * Takes over the data of another grid, leaving it empty (with zero dimensions)
+	 */
+	BitGrid(BitGrid &&g) noexcept : data(g.data), w(g.w), h(g.h), words(g.words)
+	{
+		g.data = nullptr;
+		g.w = g.h = g.words = 0;
+	}
+
+	~BitGrid()
+	{
+		delete[] data;
+	}
+
+	BitGrid &operator=(const BitGrid &other)
+	{
+		if (this == &other)
+			return *this;
+		if (size() != other.size())
+		{
+			delete[] data;
+			w = other.w;
+			h = other.h;
+			words = other.words;
+			allocate();
+		}
+		else
+		{
+			w = other.w;
+			h = other.h;
+			words = other.words;
+		}
+		if (data)
+			std::copy_n(other.data, size(), data);
+		return *this;
+	}
+
+	/**
+	 * Takes over the data of another grid, leaving it empty (with zero dimensions)
+	 */
+	BitGrid &operator=(BitGrid &&other) noexcept
+	{
+		if (this == &other)
+			return *this;
+		delete[] data;
+		data = other.data;
+		w = other.w;
+		h = other.h;
+		words = other.words;
+		other.data = nullptr;
+		other.w = other.h = other.words = 0;
+		return *this;
+	}
+
+	/**
+	 * @param y index of a row
+	 * @return pointer to the first word of the row
+	 */
+	uint64_t *row(const uint32_t y) const
+	{
+		assert(y < h);
+		return data + uint64_t(y) * words;
+	}
+
+	/**
+	 * @param x x index of an entry
+	 * @param y y index of an entry
+	 * @return reference to the entry in the two-dimensional array
+	 */
+	BitRef operator()(const uint32_t x, const uint32_t y)
+	{
+		assert(x < w);
+		return BitRef(row(y)[x / WordBits], uint64_t(1) << (x % WordBits));
+	}
+
+	/**
+	 * @param x x index of an entry
+	 * @param y y index of an entry
+	 * @return value of the entry in the two-dimensional array
+	 */
+	bool operator()(const uint32_t x, const uint32_t y) const
+	{
+		assert(x < w);
+		return row(y)[x / WordBits] >> (x % WordBits) & 1;
+	}
+
+	/**
+	 * @param p (x and y) indices of an entry
+	 * @return reference to the entry in the two-dimensional array
+	 */
+	BitRef operator()(const Point &p)
+	{
+		return operator()(p.x, p.y);
+	}
+
+	/**
+	 * @param p (x and y) indices of an entry
+	 * @return value of the entry in the two-dimensional array
+	 */
+	bool operator()(const Point &p) const
+	{
+		return operator()(p.x, p.y);
+	}
+
+	/**
+	 * Sets all entries in the array to a specified value
+	 * @param val value to set all entries to
+	 */
+	void set_all(const bool val)
+	{
+		std::fill_n(data, size(), val ? ~uint64_t(0) : 0);
+		if (val && w % WordBits != 0)
+			for (uint32_t y = 0; y < h; y++)
+				row(y)[words - 1] = lowBits(w % WordBits);
+	}
+
+	/**
+	 * Sets the entries of a span of a row to a specified value
+	 * @param y index of the row
+	 * @param x0 x index of the first entry of the span
+	 * @param x1 x index past the last entry of the span
+	 * @param val value to set the entries to
+	 */
+	void set_span(const uint32_t y, const uint32_t x0, const uint32_t x1, const bool val)
+	{
+		assert(x0 <= x1 && x1 <= w);
+		if (x0 == x1)
+			return;
+		uint64_t *const r = row(y);
+		const uint32_t first = x0 / WordBits, last = (x1 - 1) / WordBits;
+		for (uint32_t i = first; i <= last; i++)
+		{
+			// the bits of the span in the i-th word
+			uint64_t m = ~uint64_t(0);
+			if (i == first)
+				m &= ~lowBits(x0 % WordBits);
+			if (i == last && x1 % WordBits != 0)
+				m &= lowBits(x1 % WordBits);
+			r[i] = val ? r[i] | m : r[i] & ~m;
+		}
+	}
+
+	/**
+	 * Sets every entry that is true in another grid to true
+	 * @param other grid of the same dimensions
+	 */
+	void unite(const BitGrid &other)
+	{
+		assert(w == other.w && h == other.h);
+		for (uint64_t i = 0; i < size(); i++)
+			data[i] |= other.data[i];
+	}
+
+	/**
+	 * Sets every entry that is true in another grid to false
+	 * @param other grid of the same dimensions
+	 */
+	void subtract(const BitGrid &other)
+	{
+		assert(w == other.w && h == other.h);
+		for (uint64_t i = 0; i < size(); i++)
+			data[i] &= ~other.data[i];
+	}
+
+	/**
+	 * @return number of true entries in the array
+	 */
+	uint64_t count() const
+	{
+		uint64_t ret = 0;
+		for (uint64_t i = 0; i < size(); i++)
+			ret += __builtin_popcountll(data[i]);
+		return ret;
+	}
+
+	/**
+	 * Calls a function for every maximal run of true entries of a row (in the order of increasing x)
+	 * @param y index of the row
+	 * @param fn function taking the run
+	 */
+	template <typename F>
+	void forEachRun(const uint32_t y, const F &fn) const
+	{
+		const uint64_t *const r = row(y);
+		uint32_t x = find(r, 0, true);
+		while (x < w)
+		{
+			const uint32_t x1 = find(r, x, false);
+			fn(GridRun{y, x, x1});
+			x = find(r, x1, true);
+		}
+	}
+
+	/**
+	 * @return number of words allocated for the array
+	 */
+	uint64_t size() const
+	{
+		return uint64_t(h) * words;
+	}
+
+private:
+	/**
+	 * @param n number of bits (less than WordBits)
+	 * @return word with the lowest n bits set
+	 */
+	static uint64_t lowBits(const uint32_t n)
+	{
+		return (uint64_t(1) << n) - 1;
+	}
+
+	/**
+	 * @param r pointer to the first word of a row
+	 * @param x x index to start the search at
+	 * @param val value to search for
+	 * @return x index of the first entry at or after x with the value val (w if there's none)
+	 */
+	uint32_t find(const uint64_t *const r, uint32_t x, const bool val) const
+	{
+		while (x < w)
+		{
+			// the bits below x are cleared (and the padding bits past w, which are zero, only ever match when searching for false)
+			const uint64_t word = (val ? r[x / WordBits] : ~r[x / WordBits]) & ~lowBits(x % WordBits);
+			if (word != 0)
+				return std::min(w, x / WordBits * WordBits + __builtin_ctzll(word));
+			x = (x / WordBits + 1) * WordBits;
+		}
+		return w;
+	}
+
+	/**
+	 * Allocates the data for the current dimensions (zeroed, so that the padding bits are zero)
+	 */
+	void allocate()
+	{
+		if (w == 0 || h == 0)
+			data = nullptr;
+		else
+			data = new uint64_t[size()]();
+	}
+};
+
+}
+
+#endif // BIT_GRID_HPP
@@ -53,6 +53,15 @@ struct Grid
 			std::copy_n(g.data, w * h, data);
 	}
 
+	/**
+	 * Takes over the data of another grid, leaving it empty (with zero dimensions)
+	 */
+	Grid(Grid &&g) noexcept : data(g.data), w(g.w), h(g.h)
+	{
+		g.data = nullptr;
+		g.w = g.h = 0;
+	}
+
 	~Grid()
 	{
 		if (w != 0 && h != 0)
@@ -101,6 +110,23 @@ struct Grid
 		return *this;
 	}
 
+	/**
+	 * Takes over the data of another grid, leaving it empty (with zero dimensions)
+	 */
+	Grid &operator=(Grid &&other) noexcept
+	{
+		if (this == &other)
+			return *this;
+		if (w != 0 && h != 0)
+			delete[] data;
+		data = other.data;
+		w = other.w;
+		h = other.h;
+		other.data = nullptr;
+		other.w = other.h = 0;
+		return *this;
+	}
+
 	/**
 	 * Sets all entries in the array to a specified value
 	 * @param val value to set all entries to
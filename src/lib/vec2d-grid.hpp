@@ -0,0 +1,287 @@
+/**
+ * vec2d-grid.hpp
+ *
+ * Author: Viktor Fukala
+ * Created on 2026/10/17
+ */
+#ifndef VEC2D_GRID_HPP
+#define VEC2D_GRID_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include <new>
+
+#include "point.hpp"
+#include "vec2d.hpp"
+
+namespace brandy0
+{
+
+/**
+ * Reference to an entry of a Vec2dGrid (whose components are stored in separate planes).
+ * Behaves like a reference to a vec2d: its components can be read and written and a vec2d can be assigned to it.
+ */
+struct Vec2dRef
+{
+	/// Reference to the x component of the entry
+	double &x;
+	/// Reference to the y component of the entry
+	double &y;
+
+	/**
+	 * Constructs a reference to an entry given references to its components
+	 * @param x reference to the x component
+	 * @param y reference to the y component
+	 */
+	Vec2dRef(double &x, double &y) : x(x), y(y)
+	{
+	}
+
+	Vec2dRef(const Vec2dRef &) = default;
+
+	/**
+	 * Assigns the value of another entry to this entry (the references are not rebound)
+	 */
+	Vec2dRef &operator=(const Vec2dRef &other)
+	{
+		x = other.x;
+		y = other.y;
+		return *this;
+	}
+
+	/**
+	 * Assigns a vector to this entry
+	 */
+	Vec2dRef &operator=(const vec2d &v)
+	{
+		x = v.x;
+		y = v.y;
+		return *this;
+	}
+
+	/**
+	 * @return value of the entry
+	 */
+	operator vec2d() const
+	{
+		return vec2d(x, y);
+	}
+};
+
+/**
+ * Struct for holding a two-dimensional array of vectors in the structure-of-arrays layout:
+ * the x and the y components are stored in two separate planes (each in row major order),
+ * so that a computation using only one component reads only its plane and the rows can be loaded by SIMD instructions.
+ * Each row of each plane starts at an address aligned to Alignment bytes.
+ */
+struct Vec2dGrid
+{
+	/// Alignment (in bytes) of the start of each row
+	static constexpr uint32_t Alignment = 64;
+
+	/**
+	 * Pointer to the data (the plane of the x components followed by the plane of the y components).
+	 * Should be nullptr iff either w or h is 0.
+	 */
+	double *data;
+	/// Width of the two-dimensional array
+	uint32_t w;
+	/// Height of the two-dimensional array
+	uint32_t h;
+	/// Distance (in doubles) between the starts of two consecutive rows of a plane (w rounded up to a multiple of the alignment)
+	uint32_t stride;
+
+	/**
+	 * Creates a Vec2dGrid object of specified dimensions
+	 * @param w width of the array
+	 * @param h height of the array
+	 */
+	Vec2dGrid(const uint32_t w, const uint32_t h) : w(w), h(h)
+	{
+		constexpr uint32_t perAlignment = Alignment / sizeof(double);
+		stride = (w + perAlignment - 1) / perAlignment * perAlignment;
+		allocate();
+	}
+
+	Vec2dGrid(const Vec2dGrid &g) : Vec2dGrid(g.w, g.h)
+	{
+		if (data)
+			std::copy_n(g.data, size(), data);
+	}
+
+	/**
+	 * Takes over the data of another grid, leaving it empty (with zero dimensions)
+	 */
+	Vec2dGrid(Vec2dGrid &&g) noexcept : data(g.data), w(g.w), h(g.h), stride(g.stride)
+	{
+		g.data = nullptr;
+		g.w = g.h = g.stride = 0;
+	}
+
+	~Vec2dGrid()
+	{
+		release();
+	}
+
+	Vec2dGrid &operator=(const Vec2dGrid &other)
+	{
+		if (this == &other)
+			return *this;
+		if (size() != other.size())
+		{
+			release();
+			w = other.w;
+			h = other.h;
+			stride = other.stride;
+			allocate();
+		}
+		else
+		{
+			w = other.w;
+			h = other.h;
+			stride = other.stride;
+		}
+		if (data)
+			std::copy_n(other.data, size(), data);
+		return *this;
+	}
+
+	/**
+	 * Takes over the data of another grid, leaving it empty (with zero dimensions)
+	 */
+	Vec2dGrid &operator=(Vec2dGrid &&other) noexcept
+	{
+		if (this == &other)
+			return *this;
+		release();
+		data = other.data;
+		w = other.w;
+		h = other.h;
+		stride = other.stride;
+		other.data = nullptr;
+		other.w = other.h = other.stride = 0;
+		return *this;
+	}
+
+	/**
+	 * @param y index of a row
+	 * @return pointer to the x component of the first entry of the row
+	 */
+	double *xRow(const uint32_t y) const
+	{
+		assert(y < h);
+		return data + uint64_t(y) * stride;
+	}
+
+	/**
+	 * @param y index of a row
+	 * @return pointer to the y component of the first entry of the row
+	 */
+	double *yRow(const uint32_t y) const
+	{
+		assert(y < h);
+		return data + uint64_t(h + y) * stride;
+	}
+
+	/**
+	 * @param x x index of an entry
+	 * @param y y index of an entry
+	 * @return reference to the entry in the two-dimensional array
+	 */
+	Vec2dRef operator()(const uint32_t x, const uint32_t y)
+	{
+		assert(x < w);
+		return Vec2dRef(xRow(y)[x], yRow(y)[x]);
+	}
+
+	/**
+	 * @param x x index of an entry
+	 * @param y y index of an entry
+	 * @return value of the entry in the two-dimensional array
+	 */
+	vec2d operator()(const uint32_t x, const uint32_t y) const
+	{
+		assert(x < w);
+		return vec2d(xRow(y)[x], yRow(y)[x]);
+	}
+
+	/**
+	 * @param p (x and y) indices of an entry
+	 * @return reference to the entry in the two-dimensional array
+	 */
+	Vec2dRef operator()(const Point &p)
+	{
+		return operator()(p.x, p.y);
+	}
+
+	/**
+	 * @param p (x and y) indices of an entry
+	 * @return value of the entry in the two-dimensional array
+	 */
+	vec2d operator()(const Point &p) const
+	{
+		return operator()(p.x, p.y);
+	}
+
+	/**
+	 * Sets all entries in the array to a specified value
+	 * @param val value to set all entries to
+	 */
+	void set_all(const vec2d val)
+	{
+		std::fill_n(data, uint64_t(h) * stride, val.x);
+		std::fill_n(data + uint64_t(h) * stride, uint64_t(h) * stride, val.y);
+	}
+
+private:
+	/**
+	 * @return number of doubles allocated for both planes
+	 */
+	uint64_t size() const
+	{
+		return 2 * uint64_t(h) * stride;
+	}
+
+	/**
+	 * Allocates the data for the current dimensions
+	 */
+	void allocate()
+	{
+		if (w == 0 || h == 0)
+			data = nullptr;
+		else
+			data = new (std::align_val_t(Alignment)) double[size()];
+	}
+
+	/**
+	 * Deallocates the data
+	 */
+	void release()
+	{
+		if (data)
+			operator delete[](data, std::align_val_t(Alignment));
+		data = nullptr;
+	}
+};
+
+/**
+ * Finds the maximum value of a function applied on an entry in a vector grid. The type S should overload the < operator.
+ * @param grid grid to take the entries from (should contain at least one entry)
+ * @param evaluator function that assigns values to entries in the grid
+ * @return maximum of all the values that the specified function produces for entries in the grid
+ */
+template <typename S>
+S max(const Vec2dGrid &grid, const std::function<S(vec2d)> &evaluator)
+{
+	S best = evaluator(grid(0, 0));
+	for (uint32_t y = 0; y < grid.h; y++)
+		for (uint32_t x = 0; x < grid.w; x++)
+			best = std::max(best, evaluator(grid(x, y)));
+	return best;
+}
+
+}
+
+#endif // VEC2D_GRID_HPP